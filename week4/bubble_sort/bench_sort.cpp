@@ -0,0 +1,270 @@
+// Benchmark of the sorting algorithms.
+//
+// Runs every sort over every input distribution and size and reports:
+//   - the time per element in nanoseconds (best of several runs)
+//   - the number of comparisons and element moves (copies count as moves),
+//     counted in a separate run on an instrumented element type. The generic
+//     code paths are counted, e.g. pdqsort without its branchless partition.
+//
+// A human readable table goes to stdout, the same data as CSV goes to the file
+// given with '--csv' (default: bench_sort.csv).
+//
+// Usage: ./bench_sort [--sizes 10,1000,1000000] [--threads N]
+//                     [--bubble-max N] [--csv FILE]
+
+#include <algorithm>  // std::sort, std::stable_sort, std::is_sorted
+#include <atomic>     // std::atomic
+#include <chrono>     // Timing capabilities
+#include <cstdlib>    // std::strtoul
+#include <cstring>    // std::strcmp
+#include <fstream>    // std::ofstream
+#include <functional>
+#include <iomanip>  // std::setw
+#include <iostream>
+#include <random>  // std::mt19937
+#include <sstream>
+#include <string>
+#include <thread>  // std::thread::hardware_concurrency
+#include <vector>
+
+#include "bubble_sort.h"
+#include "parallel_sort.h"
+#include "radix_sort.h"
+#include "sort.h"
+#include "thread_pool.h"
+
+struct options {
+    std::vector<size_t> sizes = {10, 100, 1000, 10000, 100000, 1000000,
+                                 10000000};
+    unsigned threads = std::thread::hardware_concurrency();
+    // bubble_sort is quadratic: skip it above this size
+    size_t bubble_max = 10000;
+    std::string csv = "bench_sort.csv";
+};
+
+struct result_row {
+    std::string algorithm;
+    std::string distribution;
+    size_t n;
+    double ns_per_element;
+    bool counted;  // comparisons and moves are known
+    size_t comparisons;
+    size_t moves;
+    bool ok;
+};
+
+// --- Input distributions
+
+const char *const distributions[] = {"random",      "sorted",
+                                     "reverse",     "organ_pipe",
+                                     "few_unique",  "nearly_sorted"};
+
+std::vector<int> make_input(const std::string &distribution, size_t n,
+                            std::mt19937 &gen) {
+    std::vector<int> v(n);
+    const int size = static_cast<int>(n);
+    for (int i = 0; i < size; ++i) {
+        if (distribution == "random")
+            v[i] = static_cast<int>(gen());
+        else if (distribution == "sorted" || distribution == "nearly_sorted")
+            v[i] = i;
+        else if (distribution == "reverse")
+            v[i] = size - i;
+        else if (distribution == "organ_pipe")
+            v[i] = i < size / 2 ? i : size - i;
+        else if (distribution == "few_unique")
+            v[i] = gen() % 16;
+    }
+    if (distribution == "nearly_sorted" && n > 1) {
+        // Swap 1% of the elements with a random partner
+        std::uniform_int_distribution<size_t> pos(0, n - 1);
+        for (size_t s = 0; s < n / 100 + 1; ++s)
+            std::swap(v[pos(gen)], v[pos(gen)]);
+    }
+    return v;
+}
+
+// --- Instrumented element type
+
+std::atomic<size_t> comparisons(0), moves(0);
+
+struct counted {
+    int value = 0;
+
+    counted() = default;
+    counted(int v) : value(v) {}
+    counted(const counted &other) : value(other.value) {
+        moves.fetch_add(1, std::memory_order_relaxed);
+    }
+    counted &operator=(const counted &other) {
+        value = other.value;
+        moves.fetch_add(1, std::memory_order_relaxed);
+        return *this;
+    }
+};
+
+bool operator<(const counted &lhs, const counted &rhs) {
+    comparisons.fetch_add(1, std::memory_order_relaxed);
+    return lhs.value < rhs.value;
+}
+
+// --- The algorithms. Each one can sort a vector of int (timed) and a vector
+// of counted (for the counts); bubble_sort only exists for int.
+
+struct algorithm {
+    std::string name;
+    std::function<void(std::vector<int> &)> sort;
+    std::function<void(std::vector<counted> &)> sort_counted;
+};
+
+std::vector<algorithm> make_algorithms(thread_pool &pool) {
+    auto key = [](const counted &c) { return c.value; };
+    std::vector<algorithm> list = {
+        {"bubble_sort", [](std::vector<int> &v) { bubble_sort(v); }, nullptr},
+        {"std::sort", [](std::vector<int> &v) { std::sort(v.begin(), v.end()); },
+         [](std::vector<counted> &v) { std::sort(v.begin(), v.end()); }},
+        {"std::stable_sort",
+         [](std::vector<int> &v) { std::stable_sort(v.begin(), v.end()); },
+         [](std::vector<counted> &v) { std::stable_sort(v.begin(), v.end()); }},
+        {"pdqsort", [](std::vector<int> &v) { pdqsort(v.begin(), v.end()); },
+         [](std::vector<counted> &v) { pdqsort(v.begin(), v.end()); }},
+        {"radix_sort",
+         [](std::vector<int> &v) { radix_sort(v.begin(), v.end()); },
+         [key](std::vector<counted> &v) {
+             radix_sort(v.begin(), v.end(), key);
+         }},
+        {"parallel_sort",
+         [&pool](std::vector<int> &v) {
+             parallel_sort(pool, v.begin(), v.end());
+         },
+         [&pool](std::vector<counted> &v) {
+             parallel_sort(pool, v.begin(), v.end());
+         }},
+        {"parallel_stable_sort",
+         [&pool](std::vector<int> &v) {
+             parallel_stable_sort(pool, v.begin(), v.end());
+         },
+         [&pool](std::vector<counted> &v) {
+             parallel_stable_sort(pool, v.begin(), v.end());
+         }},
+    };
+    return list;
+}
+
+// Sorts copies of 'input' until at least 'min_time' seconds have passed and
+// returns the fastest run in nanoseconds per element. Small inputs are sorted
+// in batches of copies, so the resolution of the clock does not matter.
+// 'ok' is cleared if a result is not sorted.
+double best_time(const algorithm &alg, const std::vector<int> &input,
+                 bool &ok, double min_time = 0.2, int min_runs = 3) {
+    const size_t n = std::max<size_t>(input.size(), 1);
+    const size_t batch = std::max<size_t>(1, 100000 / n);
+    std::vector<std::vector<int>> copies(batch);
+    double best = 1e300, total = 0;
+    for (int run = 0; run < min_runs || total < min_time; ++run) {
+        for (auto &copy : copies) copy = input;
+        auto start = std::chrono::steady_clock::now();
+        for (auto &copy : copies) alg.sort(copy);
+        auto end = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double>(end - start).count();
+        best = std::min(best, t);
+        total += t;
+        for (auto &copy : copies)
+            if (!std::is_sorted(copy.begin(), copy.end())) ok = false;
+    }
+    return best / (batch * n) * 1e9;
+}
+
+void bench(const options &opt, std::vector<result_row> &rows) {
+    thread_pool pool(opt.threads);
+    const std::vector<algorithm> algorithms = make_algorithms(pool);
+    std::mt19937 gen(42);
+
+    for (size_t n : opt.sizes)
+        for (const char *distribution : distributions) {
+            const std::vector<int> input = make_input(distribution, n, gen);
+            for (const algorithm &alg : algorithms) {
+                if (alg.name == "bubble_sort" && n > opt.bubble_max) continue;
+                result_row row = {alg.name, distribution, n, 0, false, 0, 0,
+                                  true};
+                row.ns_per_element = best_time(alg, input, row.ok);
+
+                if (alg.sort_counted) {
+                    std::vector<counted> copy(input.begin(), input.end());
+                    comparisons = 0;
+                    moves = 0;
+                    alg.sort_counted(copy);
+                    row.counted = true;
+                    row.comparisons = comparisons;
+                    row.moves = moves;
+                }
+                rows.push_back(row);
+            }
+        }
+}
+
+std::vector<size_t> parse_sizes(const std::string &list) {
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');)
+        sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+    return sizes;
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc)
+            opt.sizes = parse_sizes(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+            opt.threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--bubble-max") && i + 1 < argc)
+            opt.bubble_max = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+            opt.csv = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--sizes 10,1000,1000000] [--threads N]"
+                         " [--bubble-max N] [--csv FILE]\n";
+            return 1;
+        }
+    }
+    if (opt.threads == 0) opt.threads = 1;
+
+    std::ofstream csv(opt.csv);
+    if (!csv) {
+        std::cerr << "Could not open the file " << opt.csv << '\n';
+        return 1;
+    }
+
+    std::vector<result_row> rows;
+    bench(opt, rows);
+
+    csv << "algorithm,distribution,n,threads,ns_per_element,comparisons,"
+           "moves,ok\n";
+    std::cout << std::left << std::setw(22) << "algorithm" << std::setw(15)
+              << "distribution" << std::right << std::setw(10) << "n"
+              << std::setw(10) << "ns/elem" << std::setw(14) << "compares"
+              << std::setw(14) << "moves" << "  check\n";
+    for (const auto &r : rows) {
+        const bool parallel = r.algorithm.compare(0, 8, "parallel") == 0;
+        csv << r.algorithm << ',' << r.distribution << ',' << r.n << ','
+            << (parallel ? opt.threads : 1) << ',' << r.ns_per_element << ',';
+        if (r.counted) csv << r.comparisons << ',' << r.moves;
+        else csv << ',';
+        csv << ',' << (r.ok ? "ok" : "FAIL") << '\n';
+
+        std::cout << std::left << std::setw(22) << r.algorithm << std::setw(15)
+                  << r.distribution << std::right << std::setw(10) << r.n
+                  << std::fixed << std::setprecision(2) << std::setw(10)
+                  << r.ns_per_element;
+        if (r.counted)
+            std::cout << std::setw(14) << r.comparisons << std::setw(14)
+                      << r.moves;
+        else
+            std::cout << std::setw(14) << '-' << std::setw(14) << '-';
+        std::cout << "  " << (r.ok ? "ok" : "FAIL") << '\n';
+    }
+
+    return 0;
+}
@@ -4,26 +4,25 @@
 
 // auto == std::vector<int>::iterator
 
-void bubble_sort(std::vector<int> &v) {
-    for (size_t i = 0, size = v.size(); i < size - 1; ++i) {
-        for (size_t j = 1; j < size - i; ++j)
-            if (v.at(j) < v.at(j - 1)) std::swap(v.at(j), v.at(j - 1));
-    }
-}
+void bubble_sort(std::vector<int> &v) { bubble_sort(v, 0, v.size()); }
 
 void bubble_sort(std::vector<int> &v, size_t from, size_t to) {
     // Calculate the size of vector only once
     size_t size = v.size();
 
-    // Check for the correct vales of 'from' and 'to'
-    if (from < 0 || to > size) {
+    // Check for the correct vales of 'from' and 'to' ('from' is unsigned, so
+    // it cannot be negative)
+    if (from > to || to > size) {
         std::cout << "ERROR: Out of Bound!\n";
         return;
     }
 
-    for (size_t i = from; i < to - 1; ++i) {
-        for (size_t j = 1; j < to - i; ++j)
-            if (v.at(j) < v.at(j - 1)) std::swap(v.at(j), v.at(j - 1));
+    // The n-th pass moves the n-th largest element of [from, to) to its
+    // final place, so every pass can stop one element earlier. The indices
+    // are checked above, hence no need for the bounds-checked v.at().
+    for (size_t end = to; end > from + 1; --end) {
+        for (size_t j = from + 1; j < end; ++j)
+            if (v[j] < v[j - 1]) std::swap(v[j], v[j - 1]);
     }
 }
 
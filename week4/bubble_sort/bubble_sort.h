@@ -8,6 +8,7 @@
 
 void bubble_sort(std::vector<int> &v);
 
+/// Sorts the elements [from, to) of 'v' and leaves the others alone
 void bubble_sort(std::vector<int> &v, size_t from, size_t to);
 
 std::ostream &operator<<(std::ostream &os, const std::vector<int> &v);
@@ -0,0 +1,344 @@
+#ifndef EXTERNAL_SORT_H_
+#define EXTERNAL_SORT_H_
+
+#include <algorithm>    // std::min, std::max
+#include <cstddef>      // size_t
+#include <cstdio>       // std::FILE, std::fopen, std::fread, std::fwrite
+#include <filesystem>   // std::filesystem::remove, temp_directory_path
+#include <functional>   // std::less
+#include <random>       // std::random_device
+#include <stdexcept>    // std::runtime_error, std::invalid_argument
+#include <string>       // std::string
+#include <type_traits>  // std::is_trivially_copyable
+#include <utility>      // std::swap
+#include <vector>
+
+#include "parallel_sort.h"
+#include "thread_pool.h"
+
+// --- External merge sort
+//
+// Sorts a binary file of integers (or any trivially copyable T, stored in
+// native byte order without any header) that may be much bigger than the
+// available memory:
+//
+// 1. Run formation: read as much as fits into the memory budget, sort it with
+//    parallel_sort() on all threads and write it to a temporary file (a run).
+// 2. Merge: merge the runs k at a time into the output. Every run gets an
+//    input buffer of the same size, so the disk only sees big sequential
+//    reads and writes. The smallest current element of k runs is found with
+//    a loser tree: after taking the winner only the path from its leaf to the
+//    root is replayed, which costs log2(k) comparisons (a heap needs about
+//    twice as many).
+//
+// If there are too many runs to give each of them a buffer of at least
+// 'min_buffer_bytes', the runs are merged in several passes.
+
+/// Configuration of external_sort()
+struct external_sort_options {
+    /// Upper bound of the memory used for data (runs and I/O buffers)
+    size_t memory_bytes = size_t(256) << 20;
+    /// Threads for sorting the runs (0: one per hardware thread)
+    unsigned threads = 0;
+    /// Directory for the temporary run files (empty: the system's default)
+    std::string temp_dir;
+    /// Smallest I/O buffer per run during a merge. Smaller buffers mean more
+    /// seeks between the runs.
+    size_t min_buffer_bytes = size_t(1) << 20;
+};
+
+/// What external_sort() did
+struct external_sort_stats {
+    size_t elements = 0;
+    size_t runs = 0;           // initial runs
+    size_t merge_passes = 0;   // 0 if everything fit into memory
+    size_t bytes_written = 0;  // including the temporary files
+};
+
+namespace external_sort_detail {
+
+inline std::FILE *open(const std::string &path, const char *mode) {
+    std::FILE *file = std::fopen(path.c_str(), mode);
+    if (!file) throw std::runtime_error("ERROR: cannot open " + path);
+    // Our buffers are big enough, the one of stdio would only add a copy
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    return file;
+}
+
+// Closes the file when it goes out of scope
+struct file_handle {
+    std::FILE *file;
+    explicit file_handle(std::FILE *f) : file(f) {}
+    ~file_handle() {
+        if (file) std::fclose(file);
+    }
+    file_handle(const file_handle &) = delete;
+    file_handle &operator=(const file_handle &) = delete;
+    file_handle(file_handle &&other) noexcept : file(other.file) {
+        other.file = nullptr;
+    }
+};
+
+// Reads the elements of a file sequentially through a buffer of 'capacity'
+// elements
+template <typename T>
+class run_reader {
+public:
+    run_reader(const std::string &path, size_t capacity)
+        : handle(open(path, "rb")), buffer(std::max<size_t>(capacity, 1)) {
+        refill();
+    }
+
+    bool done() const { return pos == size; }
+    const T &front() const { return buffer[pos]; }
+    void pop() {
+        if (++pos == size) refill();
+    }
+
+private:
+    void refill() {
+        size = std::fread(buffer.data(), sizeof(T), buffer.size(),
+                          handle.file);
+        if (size == 0 && std::ferror(handle.file))
+            throw std::runtime_error("ERROR: reading a run failed");
+        pos = 0;
+    }
+
+    file_handle handle;
+    std::vector<T> buffer;
+    size_t pos = 0, size = 0;
+};
+
+// Writes elements sequentially through a buffer of 'capacity' elements
+template <typename T>
+class run_writer {
+public:
+    run_writer(const std::string &path, size_t capacity)
+        : handle(open(path, "wb")) {
+        buffer.reserve(std::max<size_t>(capacity, 1));
+    }
+
+    void push(const T &value) {
+        buffer.push_back(value);
+        if (buffer.size() == buffer.capacity()) flush();
+    }
+
+    void write(const T *data, size_t n) {
+        flush();
+        put(data, n);
+    }
+
+    // Writes the rest of the buffer and closes the file
+    void close() {
+        flush();
+        if (std::fclose(handle.file) != 0)
+            throw std::runtime_error("ERROR: writing a run failed");
+        handle.file = nullptr;
+    }
+
+    size_t bytes_written() const { return written; }
+
+private:
+    void flush() {
+        put(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+    void put(const T *data, size_t n) {
+        if (std::fwrite(data, sizeof(T), n, handle.file) != n)
+            throw std::runtime_error("ERROR: writing a run failed");
+        written += n * sizeof(T);
+    }
+
+    file_handle handle;
+    std::vector<T> buffer;
+    size_t written = 0;
+};
+
+// Tournament tree over k sorted sources. tree[0] is the index of the
+// source with the smallest current element, tree[1 .. k) hold the loser of
+// the match at that inner node. The leaf of source i is node k + i, so the
+// parent of node n is n / 2 for any k, not only powers of two.
+template <typename T, typename Compare>
+class loser_tree {
+public:
+    loser_tree(std::vector<run_reader<T>> &sources, Compare comp)
+        : sources(sources), comp(comp), k(sources.size()), tree(k) {
+        if (k > 0) tree[0] = k == 1 ? 0 : build(1);
+    }
+
+    /// The source with the smallest element (done() if all are exhausted)
+    run_reader<T> &top() { return sources[tree[0]]; }
+
+    /// Takes the smallest element and replays its path
+    void pop() {
+        size_t winner = tree[0];
+        sources[winner].pop();
+        for (size_t node = (winner + k) / 2; node > 0; node /= 2)
+            if (less(tree[node], winner)) std::swap(tree[node], winner);
+        tree[0] = winner;
+    }
+
+private:
+    // Whether source a goes before source b. Exhausted sources lose every
+    // match.
+    bool less(size_t a, size_t b) const {
+        if (sources[a].done()) return false;
+        if (sources[b].done()) return true;
+        return comp(sources[a].front(), sources[b].front());
+    }
+
+    // Plays all matches below 'node' and returns the winner
+    size_t build(size_t node) {
+        if (node >= k) return node - k;
+        size_t left = build(2 * node), right = build(2 * node + 1);
+        if (less(left, right)) {
+            tree[node] = right;
+            return left;
+        }
+        tree[node] = left;
+        return right;
+    }
+
+    std::vector<run_reader<T>> &sources;
+    Compare comp;
+    size_t k;
+    std::vector<size_t> tree;
+};
+
+// Merges the runs 'inputs' into 'output' with 'buffer_elements' per buffer
+template <typename T, typename Compare>
+size_t merge_runs(const std::vector<std::string> &inputs,
+                  const std::string &output, size_t buffer_elements,
+                  Compare comp) {
+    std::vector<run_reader<T>> sources;
+    sources.reserve(inputs.size());
+    for (const std::string &path : inputs)
+        sources.emplace_back(path, buffer_elements);
+    run_writer<T> writer(output, buffer_elements);
+
+    loser_tree<T, Compare> tree(sources, comp);
+    while (!tree.top().done()) {
+        writer.push(tree.top().front());
+        tree.pop();
+    }
+    writer.close();
+    return writer.bytes_written();
+}
+
+// Creates unique names for the temporary files and deletes them again
+class temp_files {
+public:
+    explicit temp_files(const std::string &dir) {
+        std::filesystem::path base =
+            dir.empty() ? std::filesystem::temp_directory_path()
+                        : std::filesystem::path(dir);
+        const std::string name =
+            "external_sort_" + std::to_string(std::random_device()()) + "_";
+        prefix = (base / name).string();
+    }
+    ~temp_files() {
+        std::error_code ignored;
+        for (const std::string &path : created)
+            std::filesystem::remove(path, ignored);
+    }
+
+    std::string create() {
+        created.push_back(prefix + std::to_string(created.size()) + ".run");
+        return created.back();
+    }
+
+    void remove(const std::string &path) {
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+    }
+
+private:
+    std::string prefix;
+    std::vector<std::string> created;
+};
+
+}  // namespace external_sort_detail
+
+/// Sorts the binary file 'input' (an array of T) into the file 'output' with
+/// respect to 'comp'. Throws std::runtime_error if a file cannot be read or
+/// written and std::invalid_argument if the memory budget is too small or the
+/// size of the input is not a multiple of sizeof(T).
+template <typename T, typename Compare = std::less<>>
+external_sort_stats external_sort(const std::string &input,
+                                  const std::string &output,
+                                  const external_sort_options &options = {},
+                                  Compare comp = Compare()) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "external_sort reads and writes raw bytes");
+    using namespace external_sort_detail;
+
+    // parallel_sort() needs a buffer of the same size as the run
+    const size_t run_elements = options.memory_bytes / (2 * sizeof(T));
+    const size_t min_buffer =
+        std::max<size_t>(options.min_buffer_bytes / sizeof(T), 1);
+    if (run_elements < 2 * min_buffer)
+        throw std::invalid_argument(
+            "ERROR: the memory budget has to hold at least four I/O buffers");
+    const size_t file_size = std::filesystem::file_size(input);
+    if (file_size % sizeof(T) != 0)
+        throw std::invalid_argument("ERROR: " + input +
+                                    " is not an array of the element type");
+
+    external_sort_stats stats;
+    stats.elements = file_size / sizeof(T);
+    temp_files temp(options.temp_dir);
+    thread_pool pool(options.threads);
+
+    // 1. Run formation. If everything fits into one run, it goes straight
+    // to the output.
+    std::vector<std::string> runs;
+    {
+        file_handle in(open(input, "rb"));
+        std::vector<T> run(std::min(run_elements, stats.elements));
+        size_t remaining = stats.elements;
+        do {
+            const size_t n = std::min(run.size(), remaining);
+            if (std::fread(run.data(), sizeof(T), n, in.file) != n)
+                throw std::runtime_error("ERROR: reading " + input + " failed");
+            remaining -= n;
+            parallel_sort(pool, run.begin(), run.begin() + n, comp);
+
+            const bool only_run = runs.empty() && remaining == 0;
+            runs.push_back(only_run ? output : temp.create());
+            run_writer<T> writer(runs.back(), 0);
+            writer.write(run.data(), n);
+            writer.close();
+            stats.bytes_written += writer.bytes_written();
+        } while (remaining > 0);
+    }
+    stats.runs = runs.size();
+
+    // 2. Merge passes: as many runs at once as the memory allows (one buffer
+    // per run plus one for the output)
+    const size_t memory_elements = options.memory_bytes / sizeof(T);
+    const size_t fan_in = std::max<size_t>(memory_elements / min_buffer - 1, 2);
+    while (runs.size() > 1) {
+        ++stats.merge_passes;
+        std::vector<std::string> next;
+        for (size_t first = 0; first < runs.size(); first += fan_in) {
+            const size_t last = std::min(first + fan_in, runs.size());
+            const std::vector<std::string> group(runs.begin() + first,
+                                                 runs.begin() + last);
+            if (group.size() == 1) {
+                next.push_back(group[0]);
+                continue;
+            }
+            const bool final_pass = first == 0 && last == runs.size();
+            next.push_back(final_pass ? output : temp.create());
+            const size_t buffer = memory_elements / (group.size() + 1);
+            stats.bytes_written +=
+                merge_runs<T>(group, next.back(), buffer, comp);
+            for (const std::string &path : group) temp.remove(path);
+        }
+        runs.swap(next);
+    }
+    return stats;
+}
+
+#endif  // EXTERNAL_SORT_H_
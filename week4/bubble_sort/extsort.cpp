@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "external_sort.h"
+
+// Command line front end of external_sort() plus two helpers to create and
+// verify test files.
+
+static void usage() {
+    std::cerr
+        << "usage: extsort [options] INPUT OUTPUT   sort INPUT into OUTPUT\n"
+           "       extsort --generate COUNT FILE    write COUNT random "
+           "elements\n"
+           "       extsort --check FILE             verify FILE is sorted\n"
+           "options:\n"
+           "  --type TYPE    int32, int64 (default), uint32 or uint64\n"
+           "  --memory MIB   memory budget in MiB (default 256)\n"
+           "  --threads N    threads for sorting the runs (default: all)\n"
+           "  --tmp DIR      directory for temporary files\n";
+}
+
+template <typename T>
+void generate(size_t count, const std::string &path) {
+    std::mt19937_64 rng(42);
+    external_sort_detail::run_writer<T> writer(path, 1 << 16);
+    for (size_t i = 0; i < count; ++i) writer.push(static_cast<T>(rng()));
+    writer.close();
+}
+
+template <typename T>
+bool check(const std::string &path) {
+    external_sort_detail::run_reader<T> reader(path, 1 << 16);
+    if (reader.done()) return true;
+    T previous = reader.front();
+    for (reader.pop(); !reader.done(); reader.pop()) {
+        if (reader.front() < previous) return false;
+        previous = reader.front();
+    }
+    return true;
+}
+
+template <typename T>
+int run(const std::string &mode, const std::vector<std::string> &files,
+        const external_sort_options &options) {
+    if (mode == "generate") {
+        generate<T>(std::stoull(files[0]), files[1]);
+        return 0;
+    }
+    if (mode == "check") {
+        const bool sorted = check<T>(files[0]);
+        std::cout << files[0] << (sorted ? " is sorted\n" : " is NOT sorted\n");
+        return sorted ? 0 : 1;
+    }
+    external_sort_stats stats =
+        external_sort<T>(files[0], files[1], options);
+    std::cout << "elements: " << stats.elements << '\n'
+              << "runs: " << stats.runs << '\n'
+              << "merge passes: " << stats.merge_passes << '\n'
+              << "bytes written: " << stats.bytes_written << '\n';
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    external_sort_options options;
+    std::string type = "int64", mode = "sort";
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--type" && has_value) {
+            type = argv[++i];
+        } else if (arg == "--memory" && has_value) {
+            options.memory_bytes = std::stoull(argv[++i]) << 20;
+        } else if (arg == "--threads" && has_value) {
+            options.threads = std::stoul(argv[++i]);
+        } else if (arg == "--tmp" && has_value) {
+            options.temp_dir = argv[++i];
+        } else if (arg == "--generate") {
+            mode = "generate";
+        } else if (arg == "--check") {
+            mode = "check";
+        } else if (arg == "--help" || arg.compare(0, 2, "--") == 0) {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() != (mode == "check" ? 1u : 2u)) {
+        usage();
+        return 1;
+    }
+
+    try {
+        if (type == "int32") return run<int32_t>(mode, files, options);
+        if (type == "int64") return run<int64_t>(mode, files, options);
+        if (type == "uint32") return run<uint32_t>(mode, files, options);
+        if (type == "uint64") return run<uint64_t>(mode, files, options);
+        std::cerr << "ERROR: unknown type " << type << '\n';
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
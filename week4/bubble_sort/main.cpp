@@ -14,6 +14,10 @@
 #include <vector>
 
 #include "bubble_sort.h"
+#include "parallel_sort.h"
+#include "radix_sort.h"
+#include "select.h"
+#include "sort.h"
 
 int main() {
     std::vector<int> v = {1, 5, 6, 23, 7, 8, 9, 21, 12, 4};
@@ -30,5 +34,31 @@ int main() {
     std::cout << "partially sorted: ";
     std::cout << w << '\n';
 
+    std::vector<int> u = {1, 5, 6, 23, 7, 8, 9, 21, 12, 4};
+    bubble_sort(u, 3, 8);
+    std::cout << "sorted [3, 8): ";
+    std::cout << u << '\n';
+
+    std::vector<int> x = {1, 5, 6, 23, 7, 8, 9, 21, 12, 4};
+    pdqsort(x.begin(), x.end(), std::greater<int>());
+    std::cout << "pdqsort, descending: ";
+    std::cout << x << '\n';
+
+    std::vector<int> y = {1, -5, 6, 23, -7, 8, 9, 21, -12, 4};
+    radix_sort(y.begin(), y.end());
+    std::cout << "radix_sort: ";
+    std::cout << y << '\n';
+
+    std::vector<int> z = {1, 5, 6, 23, 7, 8, 9, 21, 12, 4};
+    parallel_stable_sort(z.begin(), z.end());
+    std::cout << "parallel_stable_sort: ";
+    std::cout << z << '\n';
+
+    std::vector<int> top = {1, 5, 6, 23, 7, 8, 9, 21, 12, 4};
+    top_k(top.begin(), top.begin() + 3, top.end(), std::greater<int>());
+    top.resize(3);
+    std::cout << "3 largest: ";
+    std::cout << top << '\n';
+
     return 0;
 }
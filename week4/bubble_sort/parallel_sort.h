@@ -0,0 +1,202 @@
+#ifndef PARALLEL_SORT_H_
+#define PARALLEL_SORT_H_
+
+#include <algorithm>   // std::merge, std::stable_sort, std::min
+#include <cstddef>     // size_t
+#include <functional>  // std::less
+#include <iterator>    // std::iterator_traits, std::make_move_iterator
+#include <memory>      // std::allocator, std::uninitialized_move, std::destroy
+#include <vector>
+
+#include "sort.h"
+#include "thread_pool.h"
+
+// --- Parallel merge sort
+//
+// 1. The input is cut into one run per thread and every thread sorts its run
+//    (pdqsort, or std::stable_sort for the stable version) and moves it into
+//    a buffer of the same size.
+// 2. Neighbouring runs are merged pairwise, back and forth between the buffer
+//    and the input, until one run is left: ceil(log2(threads)) rounds.
+//
+// In the later rounds there are fewer merges than threads, so every merge is
+// split into pieces of about n / threads output elements with the "merge
+// path" (Odeh et al., 2012): the first k elements of merge(A, B) are the
+// first i of A and the first k - i of B, and i can be found with a binary
+// search. The pieces can then be merged independently, so every round keeps
+// all threads busy and the sort scales with the number of threads.
+//
+// Equal elements are always taken from the left run first, so the merge
+// phase is stable and the result is stable if the runs were sorted stably.
+
+namespace parallel_sort_detail {
+
+// Below this size the sort runs on the calling thread only
+const size_t sequential_threshold = 1 << 14;
+
+// Returns how many elements of 'a' (size 'm') are among the first 'k'
+// elements of the stable merge of 'a' and 'b' (size 'l')
+template <typename It, typename Compare>
+size_t co_rank(size_t k, It a, size_t m, It b, size_t l, Compare comp) {
+    size_t lo = k > l ? k - l : 0, hi = std::min(k, m);
+    while (lo < hi) {
+        const size_t i = lo + (hi - lo) / 2;
+        // a[i] goes before b[k - i - 1] (ties go to 'a'): i is too small
+        if (!comp(b[k - i - 1], a[i]))
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+// One piece of a merge round: output [out_first, out_last) of the merge of
+// the runs [a, a + m) and [b, b + l) that starts at 'out'. It takes the
+// elements [a_first, a_last) of the first run (from co_rank()).
+struct piece {
+    size_t a, m, b, l, out, out_first, out_last;
+    size_t a_first, a_last;
+};
+
+template <typename T, typename It, typename Compare>
+void sort_impl(thread_pool &pool, It first, It last, Compare comp,
+               bool stable) {
+    const size_t n = last - first;
+    const size_t threads = pool.size();
+    if (n < sequential_threshold || threads == 1) {
+        if (stable)
+            std::stable_sort(first, last, comp);
+        else
+            pdqsort(first, last, comp);
+        return;
+    }
+
+    // Raw memory; the elements are constructed by the moves in phase 1
+    std::allocator<T> alloc;
+    T *buffer = alloc.allocate(n);
+    struct buffer_guard {
+        std::allocator<T> &alloc;
+        T *buffer;
+        size_t n;
+        bool constructed = false;
+        ~buffer_guard() {
+            if (constructed) std::destroy(buffer, buffer + n);
+            alloc.deallocate(buffer, n);
+        }
+    } guard{alloc, buffer, n};
+
+    // Run r is [bounds[r], bounds[r + 1])
+    std::vector<size_t> bounds(threads + 1);
+    for (size_t r = 0; r <= threads; ++r) bounds[r] = n * r / threads;
+
+    // Phase 1: sort the runs and move them into the buffer
+    pool.run(threads, [&](size_t r) {
+        It run_first = first + bounds[r], run_last = first + bounds[r + 1];
+        if (stable)
+            std::stable_sort(run_first, run_last, comp);
+        else
+            pdqsort(run_first, run_last, comp);
+        std::uninitialized_move(run_first, run_last, buffer + bounds[r]);
+    });
+    guard.constructed = true;
+
+    // Phase 2: merge rounds. The data is in the buffer ('in_buffer') or in
+    // the input.
+    bool in_buffer = true;
+    const size_t piece_size = (n + threads - 1) / threads;
+    std::vector<piece> pieces;
+    while (bounds.size() > 2) {
+        pieces.clear();
+        std::vector<size_t> merged;
+        for (size_t r = 0; r + 1 < bounds.size(); r += 2) {
+            merged.push_back(bounds[r]);
+            // A run without a partner is "merged" with an empty one (copied)
+            const size_t mid = bounds[r + 1];
+            const size_t end = r + 2 < bounds.size() ? bounds[r + 2] : mid;
+            for (size_t k = bounds[r]; k < end; k += piece_size)
+                pieces.push_back({bounds[r], mid - bounds[r], mid, end - mid,
+                                  bounds[r], k - bounds[r],
+                                  std::min(k + piece_size, end) - bounds[r],
+                                  0, 0});
+        }
+        merged.push_back(n);
+
+        // All split points have to be known before the first element is
+        // moved out of the source
+        auto split_piece = [&](auto src, piece &p) {
+            p.a_first = co_rank(p.out_first, src + p.a, p.m, src + p.b, p.l,
+                                comp);
+            p.a_last =
+                co_rank(p.out_last, src + p.a, p.m, src + p.b, p.l, comp);
+        };
+        auto merge_piece = [&](auto src, auto dst, const piece &p) {
+            std::merge(
+                std::make_move_iterator(src + p.a + p.a_first),
+                std::make_move_iterator(src + p.a + p.a_last),
+                std::make_move_iterator(src + p.b + p.out_first - p.a_first),
+                std::make_move_iterator(src + p.b + p.out_last - p.a_last),
+                dst + p.out + p.out_first, comp);
+        };
+        pool.run(pieces.size(), [&](size_t i) {
+            if (in_buffer)
+                split_piece(buffer, pieces[i]);
+            else
+                split_piece(first, pieces[i]);
+        });
+        pool.run(pieces.size(), [&](size_t i) {
+            if (in_buffer)
+                merge_piece(buffer, first, pieces[i]);
+            else
+                merge_piece(first, buffer, pieces[i]);
+        });
+        in_buffer = !in_buffer;
+        bounds.swap(merged);
+    }
+
+    if (in_buffer)
+        pool.run(threads, [&](size_t r) {
+            const size_t from = n * r / threads, to = n * (r + 1) / threads;
+            std::move(buffer + from, buffer + to, first + from);
+        });
+}
+
+}  // namespace parallel_sort_detail
+
+/// The pool used by the parallel sorts if none is given: one thread per
+/// hardware thread, started on first use
+inline thread_pool &default_thread_pool() {
+    static thread_pool pool;
+    return pool;
+}
+
+/// Sorts [first, last) with respect to 'comp' on all threads of 'pool'. Not
+/// stable. Needs a buffer of the same size as the range.
+template <typename RandomIt, typename Compare = std::less<>>
+void parallel_sort(thread_pool &pool, RandomIt first, RandomIt last,
+                   Compare comp = Compare()) {
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    parallel_sort_detail::sort_impl<T>(pool, first, last, comp, false);
+}
+
+/// Like parallel_sort(), but equal elements keep their order
+template <typename RandomIt, typename Compare = std::less<>>
+void parallel_stable_sort(thread_pool &pool, RandomIt first, RandomIt last,
+                          Compare comp = Compare()) {
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    parallel_sort_detail::sort_impl<T>(pool, first, last, comp, true);
+}
+
+/// Sorts [first, last) in ascending order on default_thread_pool()
+template <typename RandomIt, typename Compare = std::less<>>
+void parallel_sort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    parallel_sort(default_thread_pool(), first, last, comp);
+}
+
+/// Stable version of the above
+template <typename RandomIt, typename Compare = std::less<>>
+void parallel_stable_sort(RandomIt first, RandomIt last,
+                          Compare comp = Compare()) {
+    parallel_stable_sort(default_thread_pool(), first, last, comp);
+}
+
+#endif  // PARALLEL_SORT_H_
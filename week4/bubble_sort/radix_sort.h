@@ -0,0 +1,143 @@
+#ifndef RADIX_SORT_H_
+#define RADIX_SORT_H_
+
+#include <algorithm>    // std::move (range)
+#include <cstddef>      // size_t
+#include <iterator>     // std::iterator_traits, std::make_move_iterator
+#include <type_traits>  // std::make_unsigned, std::is_integral, ...
+#include <utility>      // std::move
+#include <vector>
+
+// --- LSD radix sort
+//
+// Sorts by integer keys one byte at a time, starting with the least
+// significant one. Every pass is a counting sort: count how many keys have
+// each byte value, compute where each group starts and move the elements
+// there in their current order. This keeps every pass stable, so after the
+// last pass the elements are ordered by the whole key, in O(n * bytes) time
+// and without a single comparison.
+//
+// The histograms of all bytes are computed in one read-only pass over the
+// input up front (256 counters per byte, 8 KiB for 32-bit keys, fit in L1).
+// A byte that has the same value in every key (e.g. the upper bytes of small
+// numbers) would move every element to where it already is, so that pass is
+// skipped.
+
+namespace radix_detail {
+
+// Ranges smaller than this are sorted with (stable) insertion sort
+const ptrdiff_t insertion_threshold = 64;
+
+// Maps an integer key to an unsigned one with the same order (signed keys get
+// their sign bit flipped, so negative numbers come first)
+template <typename Key>
+typename std::make_unsigned<Key>::type to_unsigned(Key key) {
+    typedef typename std::make_unsigned<Key>::type U;
+    U u = static_cast<U>(key);
+    if (std::is_signed<Key>::value) u ^= U(1) << (8 * sizeof(U) - 1);
+    return u;
+}
+
+template <typename It, typename KeyFn>
+void insertion_sort(It begin, It end, KeyFn key) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    if (begin == end) return;
+    for (It cur = begin + 1; cur != end; ++cur) {
+        if (to_unsigned(key(*cur)) < to_unsigned(key(*(cur - 1)))) {
+            T tmp = std::move(*cur);
+            const auto k = to_unsigned(key(tmp));
+            It sift = cur;
+            do {
+                *sift = std::move(*(sift - 1));
+                --sift;
+            } while (sift != begin && k < to_unsigned(key(*(sift - 1))));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Identity key for ranges of integers
+struct identity_key {
+    template <typename T>
+    T operator()(const T &value) const {
+        return value;
+    }
+};
+
+}  // namespace radix_detail
+
+/// Sorts [first, last) by key(element), an integer of any size (signed or
+/// unsigned), in ascending order. The sort is stable, so equal keys keep
+/// their order and records can be sorted by several fields, least
+/// significant first. Needs a buffer of the same size as the range. 'key' is
+/// called several times per element and should be cheap (e.g. read a field).
+///
+///     radix_sort(people.begin(), people.end(),
+///                [](const person &p) { return p.age; });
+template <typename RandomIt, typename KeyFn>
+void radix_sort(RandomIt first, RandomIt last, KeyFn key) {
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    typedef typename std::decay<decltype(key(*first))>::type Key;
+    static_assert(std::is_integral<Key>::value,
+                  "radix_sort needs an integer key");
+    typedef typename std::make_unsigned<Key>::type U;
+    const size_t bytes = sizeof(U);
+
+    const ptrdiff_t size = last - first;
+    if (size < radix_detail::insertion_threshold) {
+        radix_detail::insertion_sort(first, last, key);
+        return;
+    }
+    const size_t n = static_cast<size_t>(size);
+
+    // One histogram per byte of the key
+    std::vector<size_t> storage(bytes * 256, 0);
+    size_t *counts[sizeof(U)];
+    for (size_t b = 0; b < bytes; ++b) counts[b] = storage.data() + b * 256;
+    for (RandomIt it = first; it != last; ++it) {
+        U k = radix_detail::to_unsigned(key(*it));
+        for (size_t b = 0; b < bytes; ++b, k >>= 8)
+            ++counts[b][k & 0xff];
+    }
+
+    // The elements move between the range and 'buffer'; 'in_buffer' tells
+    // where they currently are
+    std::vector<T> buffer(std::make_move_iterator(first),
+                          std::make_move_iterator(last));
+    bool in_buffer = true;
+    const U first_key = radix_detail::to_unsigned(key(buffer[0]));
+
+    for (size_t b = 0; b < bytes; ++b) {
+        const unsigned shift = 8 * b;
+        // The byte is the same in all keys: the pass would change nothing
+        if (counts[b][(first_key >> shift) & 0xff] == n) continue;
+
+        // Turn the counts into the start offset of every byte value
+        size_t offset[256];
+        for (size_t sum = 0, d = 0; d < 256; ++d) {
+            offset[d] = sum;
+            sum += counts[b][d];
+        }
+
+        if (in_buffer) {
+            for (T &x : buffer)
+                first[offset[(radix_detail::to_unsigned(key(x)) >> shift) &
+                             0xff]++] = std::move(x);
+        } else {
+            for (RandomIt it = first; it != last; ++it)
+                buffer[offset[(radix_detail::to_unsigned(key(*it)) >> shift) &
+                              0xff]++] = std::move(*it);
+        }
+        in_buffer = !in_buffer;
+    }
+
+    if (in_buffer) std::move(buffer.begin(), buffer.end(), first);
+}
+
+/// Sorts a range of integers in ascending order
+template <typename RandomIt>
+void radix_sort(RandomIt first, RandomIt last) {
+    radix_sort(first, last, radix_detail::identity_key());
+}
+
+#endif  // RADIX_SORT_H_
@@ -0,0 +1,155 @@
+#ifndef SELECT_H_
+#define SELECT_H_
+
+#include <algorithm>   // std::make_heap, std::sort_heap, std::partial_sort
+#include <cstddef>     // size_t
+#include <functional>  // std::less
+#include <iterator>    // std::iterator_traits
+#include <utility>     // std::move
+#include <vector>
+
+#include "sort.h"
+
+// --- Selection: the k-th element and the k smallest elements
+//
+// Finding the 100 smallest of a million elements does not need a full sort:
+//  - introselect() is quickselect: partition around a pivot like pdqsort, but
+//    only continue with the side that contains the wanted position. That takes
+//    O(n) on average. After too many unbalanced partitions it falls back to a
+//    heap (O(n log k)), so the worst case stays bounded.
+//  - top_k() and k_smallest() keep the k smallest elements seen so far in a
+//    max-heap. Most elements are bigger than the root and cost only one
+//    comparison, so for small k this is a single cheap pass over the input:
+//    O(n log k) in the worst and close to O(n) in the typical case.
+
+namespace select_detail {
+
+// top_k() uses the heap if k is at most n / heap_ratio and introselect plus a
+// sort of the first k elements otherwise
+const size_t heap_ratio = 16;
+
+// Replaces the root of the max-heap [first, first + size) by 'value' and
+// restores the heap property
+template <typename It, typename T, typename Compare>
+void replace_top(It first, size_t size, T value, Compare comp) {
+    size_t hole = 0;
+    while (true) {
+        size_t child = 2 * hole + 1;
+        if (child >= size) break;
+        if (child + 1 < size && comp(first[child], first[child + 1])) ++child;
+        if (!comp(value, first[child])) break;
+        first[hole] = std::move(first[child]);
+        hole = child;
+    }
+    first[hole] = std::move(value);
+}
+
+}  // namespace select_detail
+
+/// Rearranges [first, last) like std::nth_element: *nth becomes the element
+/// that would be there if the range was sorted, no element before it is
+/// greater and no element after it is less. O(n) on average.
+template <typename RandomIt, typename Compare>
+void introselect(RandomIt first, RandomIt nth, RandomIt last, Compare comp) {
+    using namespace sort_detail;
+    if (nth == last || last - first < 2) return;
+    RandomIt begin = first, end = last;
+    int bad_allowed = log2(last - first);
+    // See pdqsort_loop(): the element before 'begin' is the pivot of an
+    // earlier step and not greater than anything in [begin, end)
+    bool leftmost = true;
+
+    while (end - begin >= insertion_threshold) {
+        move_pivot_to_front(begin, end, comp);
+
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            // [begin, pivot_pos] are all equal to the pivot
+            RandomIt pivot_pos = partition_left(begin, end, comp);
+            if (nth <= pivot_pos) return;
+            begin = pivot_pos + 1;
+            continue;
+        }
+
+        RandomIt pivot_pos = partition_right(begin, end, comp).first;
+        if (nth == pivot_pos) return;
+        const auto size = end - begin;
+        if (pivot_pos - begin < size / 8 || end - pivot_pos < size / 8) {
+            if (--bad_allowed == 0) {
+                std::partial_sort(begin, nth + 1, end, comp);
+                return;
+            }
+        }
+        if (nth < pivot_pos) {
+            end = pivot_pos;
+        } else {
+            begin = pivot_pos + 1;
+            leftmost = false;
+        }
+    }
+
+    if (leftmost)
+        insertion_sort(begin, end, comp);
+    else
+        unguarded_insertion_sort(begin, end, comp);
+}
+
+template <typename RandomIt>
+void introselect(RandomIt first, RandomIt nth, RandomIt last) {
+    introselect(first, nth, last, std::less<>());
+}
+
+/// Rearranges [first, last) like std::partial_sort: [first, middle) becomes
+/// the smallest 'middle - first' elements in sorted order, the order of the
+/// rest is unspecified.
+template <typename RandomIt, typename Compare>
+void top_k(RandomIt first, RandomIt middle, RandomIt last, Compare comp) {
+    const size_t k = middle - first, n = last - first;
+    if (k == 0) return;
+    if (k * select_detail::heap_ratio > n) {
+        // Big k: the heap would do ~n log k comparisons on random inputs
+        introselect(first, middle - 1, last, comp);
+        pdqsort(first, middle - 1, comp);
+        return;
+    }
+
+    std::make_heap(first, middle, comp);
+    for (RandomIt it = middle; it != last; ++it)
+        if (comp(*it, *first)) {
+            auto value = std::move(*it);
+            *it = std::move(*first);
+            select_detail::replace_top(first, k, std::move(value), comp);
+        }
+    std::sort_heap(first, middle, comp);
+}
+
+template <typename RandomIt>
+void top_k(RandomIt first, RandomIt middle, RandomIt last) {
+    top_k(first, middle, last, std::less<>());
+}
+
+/// Returns the 'k' smallest elements of [first, last) in sorted order (all
+/// of them if there are fewer) without modifying the input. Works with any
+/// input iterator, so the elements can also be streamed from somewhere. Needs
+/// memory for k elements only.
+template <typename InputIt, typename Compare>
+std::vector<typename std::iterator_traits<InputIt>::value_type> k_smallest(
+    InputIt first, InputIt last, size_t k, Compare comp) {
+    std::vector<typename std::iterator_traits<InputIt>::value_type> heap;
+    if (k == 0) return heap;
+    heap.reserve(k);
+    for (; first != last && heap.size() < k; ++first) heap.push_back(*first);
+    std::make_heap(heap.begin(), heap.end(), comp);
+    for (; first != last; ++first)
+        if (comp(*first, heap.front()))
+            select_detail::replace_top(heap.begin(), k, *first, comp);
+    std::sort_heap(heap.begin(), heap.end(), comp);
+    return heap;
+}
+
+template <typename InputIt>
+std::vector<typename std::iterator_traits<InputIt>::value_type> k_smallest(
+    InputIt first, InputIt last, size_t k) {
+    return k_smallest(first, last, k, std::less<>());
+}
+
+#endif  // SELECT_H_
@@ -0,0 +1,429 @@
+#ifndef SORT_H_
+#define SORT_H_
+
+#include <algorithm>    // std::iter_swap, std::make_heap, std::sort_heap
+#include <cstddef>      // size_t
+#include <functional>   // std::less, std::greater
+#include <iterator>     // std::iterator_traits
+#include <type_traits>  // std::is_arithmetic
+#include <utility>      // std::move, std::pair
+
+// --- Pattern-defeating quicksort
+//
+// pdqsort (Orson Peters, https://arxiv.org/abs/2106.05123) is an introsort
+// that recognizes some patterns in the input:
+//  - Small ranges are sorted with insertion sort.
+//  - The pivot is the median of three, or the pseudo-median of nine (ninther)
+//    for bigger ranges.
+//  - If a partition step did not have to swap anything, the range was
+//    probably sorted already and a bounded insertion sort may finish it in
+//    O(n). Sorted and reverse sorted inputs take linear time.
+//  - If the pivot is equal to the pivot of the parent partition, the range is
+//    split into "equal to the pivot" (done) and "greater", so inputs with many
+//    duplicates take O(n * number of distinct values).
+//  - Highly unbalanced partitions shuffle a few elements to break up the
+//    pattern that caused them, and after log2(n) of them the range is heap
+//    sorted, which keeps the worst case at O(n log n).
+//
+// For arithmetic types compared with std::less/std::greater, the partition
+// step is branchless (BlockQuicksort, Edelkamp and Weiss): it first collects
+// the offsets of misplaced elements in small buffers and then swaps them, so
+// the outcome of the comparisons never has to be predicted.
+
+namespace sort_detail {
+
+// Ranges smaller than this are sorted with insertion sort
+const ptrdiff_t insertion_threshold = 24;
+// Ranges bigger than this use the ninther as pivot
+const ptrdiff_t ninther_threshold = 128;
+// partial_insertion_sort() gives up after this many element moves
+const size_t partial_insertion_limit = 8;
+// Number of elements that the branchless partition inspects per side at once
+const size_t block_size = 64;
+
+inline int log2(size_t n) {
+    int log = 0;
+    while (n >>= 1) ++log;
+    return log;
+}
+
+template <typename It, typename Compare>
+void insertion_sort(It begin, It end, Compare comp) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    if (begin == end) return;
+    for (It cur = begin + 1; cur != end; ++cur) {
+        It sift = cur, prev = cur - 1;
+        if (comp(*sift, *prev)) {
+            T tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*prev);
+            } while (sift != begin && comp(tmp, *--prev));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Insertion sort without the 'sift != begin' check. The element before
+// 'begin' must not be greater than any element in [begin, end).
+template <typename It, typename Compare>
+void unguarded_insertion_sort(It begin, It end, Compare comp) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    if (begin == end) return;
+    for (It cur = begin + 1; cur != end; ++cur) {
+        It sift = cur, prev = cur - 1;
+        if (comp(*sift, *prev)) {
+            T tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*prev);
+            } while (comp(tmp, *--prev));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Insertion sort that gives up (and returns false) as soon as it had to move
+// more than 'partial_insertion_limit' elements
+template <typename It, typename Compare>
+bool partial_insertion_sort(It begin, It end, Compare comp) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    if (begin == end) return true;
+    size_t moves = 0;
+    for (It cur = begin + 1; cur != end; ++cur) {
+        It sift = cur, prev = cur - 1;
+        if (comp(*sift, *prev)) {
+            T tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*prev);
+            } while (sift != begin && comp(tmp, *--prev));
+            *sift = std::move(tmp);
+            moves += cur - sift;
+            if (moves > partial_insertion_limit) return false;
+        }
+    }
+    return true;
+}
+
+template <typename It, typename Compare>
+void sort2(It a, It b, Compare comp) {
+    if (comp(*b, *a)) std::iter_swap(a, b);
+}
+
+template <typename It, typename Compare>
+void sort3(It a, It b, It c, Compare comp) {
+    sort2(a, b, comp);
+    sort2(b, c, comp);
+    sort2(a, b, comp);
+}
+
+// Moves the median of three (or the ninther for big ranges) to *begin. The
+// range must have at least 'insertion_threshold' elements. Afterwards there
+// is an element not greater than *begin and one not less than it in
+// (begin, end), which the partition functions rely on.
+template <typename It, typename Compare>
+void move_pivot_to_front(It begin, It end, Compare comp) {
+    const auto half = (end - begin) / 2;
+    if (end - begin > ninther_threshold) {
+        sort3(begin, begin + half, end - 1, comp);
+        sort3(begin + 1, begin + (half - 1), end - 2, comp);
+        sort3(begin + 2, begin + (half + 1), end - 3, comp);
+        sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+        std::iter_swap(begin, begin + half);
+    } else {
+        sort3(begin + half, begin, end - 1, comp);
+    }
+}
+
+// Partitions [begin, end) around the pivot *begin into "less than the pivot"
+// and "not less". Returns the final position of the pivot and whether the
+// range was partitioned already (nothing had to be swapped). Needs a median
+// of three (or more) at the front, so the scans stay inside of the range.
+template <typename It, typename Compare>
+std::pair<It, bool> partition_right(It begin, It end, Compare comp) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    T pivot = std::move(*begin);
+    It first = begin, last = end;
+
+    // Find the first element that is not less than the pivot (the median of
+    // three guarantees there is one) and the last one that is less
+    while (comp(*++first, pivot)) {
+    }
+    if (first - 1 == begin)
+        while (first < last && !comp(*--last, pivot)) {
+        }
+    else
+        while (!comp(*--last, pivot)) {
+        }
+
+    const bool already_partitioned = first >= last;
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(*++first, pivot)) {
+        }
+        while (!comp(*--last, pivot)) {
+        }
+    }
+
+    It pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// Swaps the misplaced elements collected by partition_right_branchless().
+// With 'use_swaps' they are swapped pairwise, otherwise they are rotated
+// through a single temporary (fewer moves, but it does not keep the order of
+// a descending input, which would make that case quadratic).
+template <typename It>
+void swap_offsets(It first, It last, const unsigned char *offsets_l,
+                  const unsigned char *offsets_r, size_t num, bool use_swaps) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    if (use_swaps) {
+        for (size_t i = 0; i < num; ++i)
+            std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+    } else if (num > 0) {
+        It l = first + offsets_l[0], r = last - offsets_r[0];
+        T tmp = std::move(*l);
+        *l = std::move(*r);
+        for (size_t i = 1; i < num; ++i) {
+            l = first + offsets_l[i];
+            *r = std::move(*l);
+            r = last - offsets_r[i];
+            *l = std::move(*r);
+        }
+        *r = std::move(tmp);
+    }
+}
+
+// Same as partition_right(), but without branches that depend on the
+// comparisons
+template <typename It, typename Compare>
+std::pair<It, bool> partition_right_branchless(It begin, It end,
+                                               Compare comp) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    T pivot = std::move(*begin);
+    It first = begin, last = end;
+
+    while (comp(*++first, pivot)) {
+    }
+    if (first - 1 == begin)
+        while (first < last && !comp(*--last, pivot)) {
+        }
+    else
+        while (!comp(*--last, pivot)) {
+        }
+
+    const bool already_partitioned = first >= last;
+    if (!already_partitioned) {
+        std::iter_swap(first, last);
+        ++first;
+
+        // offsets_l: elements in [first, ...) that belong to the right side,
+        // relative to offsets_l_base. offsets_r: elements in (..., last) that
+        // belong to the left side, relative to offsets_r_base (counted down).
+        alignas(64) unsigned char offsets_l[block_size];
+        alignas(64) unsigned char offsets_r[block_size];
+        It offsets_l_base = first, offsets_r_base = last;
+        size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+        while (first < last) {
+            // Refill the buffers that ran empty, splitting the unknown
+            // elements between them if both did
+            const size_t unknown = last - first;
+            const size_t left_split =
+                num_l == 0 ? (num_r == 0 ? unknown / 2 : unknown) : 0;
+            const size_t right_split = num_r == 0 ? unknown - left_split : 0;
+
+            const size_t left_count = std::min(left_split, block_size);
+            for (size_t i = 0; i < left_count; ++i) {
+                offsets_l[num_l] = static_cast<unsigned char>(i);
+                num_l += !comp(*first, pivot);
+                ++first;
+            }
+            const size_t right_count = std::min(right_split, block_size);
+            for (size_t i = 0; i < right_count; ++i) {
+                offsets_r[num_r] = static_cast<unsigned char>(i + 1);
+                num_r += comp(*--last, pivot);
+            }
+
+            const size_t num = std::min(num_l, num_r);
+            swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l,
+                         offsets_r + start_r, num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        // At most one buffer still holds misplaced elements; move them to the
+        // border between both sides
+        if (num_l) {
+            while (num_l--)
+                std::iter_swap(offsets_l_base + offsets_l[start_l + num_l],
+                               --last);
+            first = last;
+        }
+        if (num_r) {
+            while (num_r--) {
+                std::iter_swap(offsets_r_base - offsets_r[start_r + num_r],
+                               first);
+                ++first;
+            }
+        }
+    }
+
+    It pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// Partitions [begin, end) into "equal to the pivot *begin" and "greater".
+// Only used if the element before 'begin' is equal to the pivot, so nothing
+// in the range is less than it. Returns the final position of the pivot.
+template <typename It, typename Compare>
+It partition_left(It begin, It end, Compare comp) {
+    typedef typename std::iterator_traits<It>::value_type T;
+    T pivot = std::move(*begin);
+    It first = begin, last = end;
+
+    while (comp(pivot, *--last)) {
+    }
+    if (last + 1 == end)
+        while (first < last && !comp(pivot, *++first)) {
+        }
+    else
+        while (!comp(pivot, *++first)) {
+        }
+
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last)) {
+        }
+        while (!comp(pivot, *++first)) {
+        }
+    }
+
+    It pivot_pos = last;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return pivot_pos;
+}
+
+// 'leftmost': [begin, end) is the leftmost part of the whole input, i.e.
+// there is no smaller element in front of it that can stop a scan
+template <bool Branchless, typename It, typename Compare>
+void pdqsort_loop(It begin, It end, Compare comp, int bad_allowed,
+                  bool leftmost) {
+    typedef typename std::iterator_traits<It>::difference_type diff_t;
+
+    while (true) {
+        const diff_t size = end - begin;
+        if (size < insertion_threshold) {
+            if (leftmost)
+                insertion_sort(begin, end, comp);
+            else
+                unguarded_insertion_sort(begin, end, comp);
+            return;
+        }
+
+        move_pivot_to_front(begin, end, comp);
+
+        // The pivot equals the parent's pivot: all elements equal to it are
+        // put to the left side and need no further sorting
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = partition_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        const std::pair<It, bool> part =
+            Branchless ? partition_right_branchless(begin, end, comp)
+                       : partition_right(begin, end, comp);
+        const It pivot_pos = part.first;
+        const diff_t l_size = pivot_pos - begin;
+        const diff_t r_size = end - (pivot_pos + 1);
+
+        if (l_size < size / 8 || r_size < size / 8) {
+            // Highly unbalanced: fall back to heap sort if this happens too
+            // often, otherwise shuffle a few elements to defeat the pattern
+            if (--bad_allowed == 0) {
+                std::make_heap(begin, end, comp);
+                std::sort_heap(begin, end, comp);
+                return;
+            }
+            if (l_size >= insertion_threshold) {
+                std::iter_swap(begin, begin + l_size / 4);
+                std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+                if (l_size > ninther_threshold) {
+                    std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+                    std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+            if (r_size >= insertion_threshold) {
+                std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                std::iter_swap(end - 1, end - r_size / 4);
+                if (r_size > ninther_threshold) {
+                    std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    std::iter_swap(end - 2, end - (1 + r_size / 4));
+                    std::iter_swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else if (part.second &&
+                   partial_insertion_sort(begin, pivot_pos, comp) &&
+                   partial_insertion_sort(pivot_pos + 1, end, comp)) {
+            // Nothing was swapped and both sides turned out (almost) sorted
+            return;
+        }
+
+        // Recurse into the left side, loop on the right one
+        pdqsort_loop<Branchless>(begin, pivot_pos, comp, bad_allowed,
+                                 leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+// Whether the comparison of two T with Compare is cheap and has no side
+// effects, so it can be done unconditionally (branchless partition)
+template <typename T, typename Compare>
+struct is_branchless_compare : std::false_type {};
+template <typename T>
+struct is_branchless_compare<T, std::less<T>> : std::is_arithmetic<T> {};
+template <typename T>
+struct is_branchless_compare<T, std::greater<T>> : std::is_arithmetic<T> {};
+template <typename T>
+struct is_branchless_compare<T, std::less<>> : std::is_arithmetic<T> {};
+template <typename T>
+struct is_branchless_compare<T, std::greater<>> : std::is_arithmetic<T> {};
+
+}  // namespace sort_detail
+
+/// Sorts [first, last) with respect to 'comp' (a strict weak ordering, like
+/// for std::sort). Not stable. O(n log n) in the worst case, O(n) for sorted,
+/// reverse sorted and all equal inputs.
+template <typename RandomIt, typename Compare>
+void pdqsort(RandomIt first, RandomIt last, Compare comp) {
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    if (last - first < 2) return;
+    sort_detail::pdqsort_loop<
+        sort_detail::is_branchless_compare<T, Compare>::value>(
+        first, last, comp, sort_detail::log2(last - first), true);
+}
+
+/// Sorts [first, last) in ascending order
+template <typename RandomIt>
+void pdqsort(RandomIt first, RandomIt last) {
+    pdqsort(first, last, std::less<>());
+}
+
+#endif  // SORT_H_
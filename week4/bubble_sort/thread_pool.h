@@ -0,0 +1,146 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <algorithm>           // std::min
+#include <atomic>              // std::atomic
+#include <condition_variable>  // std::condition_variable
+#include <cstddef>             // size_t
+#include <deque>               // std::deque
+#include <exception>           // std::exception_ptr
+#include <functional>          // std::function
+#include <memory>              // std::shared_ptr
+#include <mutex>               // std::mutex
+#include <thread>              // std::thread
+#include <vector>              // std::vector
+
+/// A fixed set of worker threads that execute jobs from a shared queue.
+/// Starting a thread costs tens of microseconds, so code that runs many
+/// parallel steps after each other (like the merge rounds of parallel_sort)
+/// keeps the threads around instead of creating new ones for every step.
+class thread_pool {
+public:
+    /// A pool for 'threads' threads in total (0: one per hardware thread).
+    /// The thread calling run() counts as one of them, so 'threads - 1'
+    /// workers are started.
+    explicit thread_pool(unsigned threads = 0) {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+        // The destructor does not run if starting a worker fails, so the
+        // workers started so far are stopped here
+        try {
+            for (unsigned t = 1; t < threads; ++t)
+                workers.emplace_back([this] { work(); });
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    ~thread_pool() { stop(); }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    /// Number of threads that run() uses (workers plus the calling thread)
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    /// Calls task(i) for every i in [0, n) and returns when all calls are
+    /// done. The calls are spread over the workers and the calling thread.
+    /// The calling thread claims tasks too, so run() also finishes if all
+    /// workers are busy (e.g. when it is called from inside a task). If a
+    /// task throws, the remaining ones are skipped and the exception is
+    /// rethrown here.
+    template <typename Task>
+    void run(size_t n, const Task &task) {
+        if (n == 0) return;
+        // Shared with the helper jobs, which may only get to run after
+        // run() returned
+        auto state = std::make_shared<run_state>();
+        state->n = n;
+        state->task = [&task](size_t i) { task(i); };
+
+        const size_t helpers = std::min<size_t>(workers.size(), n - 1);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (size_t h = 0; h < helpers; ++h)
+                jobs.emplace_back([state] { state->claim(); });
+        }
+        if (helpers == 1)
+            wake.notify_one();
+        else if (helpers > 1)
+            wake.notify_all();
+
+        state->claim();
+        std::unique_lock<std::mutex> guard(state->lock);
+        state->finished.wait(guard, [&] { return state->done == state->n; });
+        if (state->error) std::rethrow_exception(state->error);
+    }
+
+private:
+    // Progress of one call of run()
+    struct run_state {
+        size_t n = 0;
+        std::function<void(size_t)> task;
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+
+        std::mutex lock;
+        std::condition_variable finished;
+        size_t done = 0;  // guarded by 'lock'
+        std::exception_ptr error;
+
+        // Runs tasks until there are none left
+        void claim() {
+            size_t i, count = 0;
+            while ((i = next.fetch_add(1)) < n) {
+                if (!failed) {
+                    try {
+                        task(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> guard(lock);
+                        if (!error) error = std::current_exception();
+                        failed = true;
+                    }
+                }
+                ++count;
+            }
+            if (count == 0) return;
+            std::lock_guard<std::mutex> guard(lock);
+            done += count;
+            if (done == n) finished.notify_all();
+        }
+    };
+
+    // Lets the workers finish the queued jobs and joins them
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : workers) t.join();
+        workers.clear();
+    }
+
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;  // stopping and nothing left
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;  // guarded by 'lock'
+    bool stopping = false;                   // guarded by 'lock'
+};
+
+#endif  // THREAD_POOL_H_
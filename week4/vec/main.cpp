@@ -61,6 +61,25 @@ int main() {
     std::cout << v5[0] << '\n';
     // this calls the const version of operator[], since v5 is const
     std::cout << v5[2] << '\n';
+
+    // Temporaries of a hot loop can come from an arena which is released in
+    // one go at the end of its scope (see vec_memory.h)
+    vec acc(3, 0.0);
+    for (int frame = 0; frame < 3; ++frame) {
+        vec_arena arena;
+        vec tmp = v2 * 2 - v3;  // allocated from the arena
+        acc += tmp;
+    }  // everything allocated in the arena is released here
+    std::cout << "acc: " << acc << '\n';
+
+    // Up to vec::small_size elements live inside the vec itself; beyond that
+    // the capacity grows geometrically
+    vec grow;
+    for (int i = 0; i < 20; ++i) grow.push_back(i);
+    grow.emplace_back(20);
+    std::cout << "grow: " << grow << "(capacity " << grow.capacity() << ")\n";
+    grow.shrink_to_fit();
+    std::cout << "after shrink_to_fit: capacity " << grow.capacity() << '\n';
     // At this point the destructors for all vec variables are called, because
     // all these variables go out of scope at the end of this function.
     return 0;
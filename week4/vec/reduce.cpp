@@ -0,0 +1,164 @@
+#include "reduce.h"
+
+#include <algorithm>  // std::min, std::max
+#include <atomic>
+#include <cmath>  // std::abs, std::sqrt
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "simd.h"
+
+namespace {
+
+// Pairwise summation stops splitting at blocks of this many elements
+constexpr size_t base_block = 256;
+
+// Adds up 'n' terms term(i) pairwise: halves are split at a multiple of
+// 'base_block', so the association only depends on 'n'.
+template <typename Base>
+double pairwise(size_t first, size_t last, const Base &base) {
+    if (last - first <= base_block) return base(first, last);
+    size_t half = (last - first) / 2;
+    size_t mid = first + (half + base_block - 1) / base_block * base_block;
+    return pairwise(first, mid, base) + pairwise(mid, last, base);
+}
+
+// A base block with eight independent accumulators (one SIMD register)
+template <typename Term>
+double block_sum(size_t first, size_t last, const Term &term) {
+    double acc[8] = {};
+    size_t i = first;
+    for (; i + 8 <= last; i += 8)
+        for (size_t l = 0; l < 8; ++l) acc[l] += term(i + l);
+    for (size_t l = 0; i < last; ++i, ++l) acc[l] += term(i);
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+           ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+unsigned thread_count(unsigned threads, size_t chunks) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    return static_cast<unsigned>(std::min<size_t>(threads, chunks));
+}
+
+// Computes chunk(first, last) for every chunk of [0, n) on 'threads' threads
+// and returns the results in chunk order.
+template <typename Chunk>
+std::vector<double> map_chunks(size_t n, unsigned threads,
+                               const Chunk &chunk) {
+    const size_t chunks = (n + reduce_chunk - 1) / reduce_chunk;
+    std::vector<double> partial(chunks);
+    std::atomic<size_t> next(0);
+    auto work = [&] {
+        for (size_t c; (c = next.fetch_add(1)) < chunks;)
+            partial[c] = chunk(c * reduce_chunk,
+                               std::min(n, (c + 1) * reduce_chunk));
+    };
+
+    std::vector<std::thread> pool;
+    try {
+        for (unsigned t = 1; t < thread_count(threads, chunks); ++t)
+            pool.emplace_back(work);
+    } catch (...) {
+        // Joinable threads must not be destroyed: wait for the started ones
+        // (they do all the chunks between them) before giving up
+        for (auto &t : pool) t.join();
+        throw;
+    }
+    work();
+    for (auto &t : pool) t.join();
+    return partial;
+}
+
+// Sums up [0, n): every chunk with pairwise(base), the chunk results pairwise
+template <typename Base>
+double reduce_sum(size_t n, unsigned threads, const Base &base) {
+    // A single chunk needs neither threads nor the vector of partial results
+    // (and gives the same result as the general case)
+    if (n <= reduce_chunk) return pairwise(0, n, base);
+    std::vector<double> partial =
+        map_chunks(n, threads, [&](size_t first, size_t last) {
+            return pairwise(first, last, base);
+        });
+    return pairwise(0, partial.size(), [&](size_t first, size_t last) {
+        return block_sum(first, last, [&](size_t i) { return partial[i]; });
+    });
+}
+
+// Sum of term(i) over [0, n)
+template <typename Term>
+double sum_terms(size_t n, unsigned threads, const Term &term) {
+    return reduce_sum(n, threads, [&](size_t first, size_t last) {
+        return block_sum(first, last, term);
+    });
+}
+
+// Combines the chunk results of an order independent operation
+template <typename Op>
+double fold(size_t n, unsigned threads, double init, const Op &op,
+            const double *data) {
+    auto chunk = [&](size_t first, size_t last) {
+        double acc = init;
+        for (size_t i = first; i < last; ++i) acc = op(acc, data[i]);
+        return acc;
+    };
+    if (n <= reduce_chunk) return chunk(0, n);
+    std::vector<double> partial = map_chunks(n, threads, chunk);
+    double acc = init;
+    for (double p : partial) acc = op(acc, p);
+    return acc;
+}
+
+const double *begin(const vec &v) { return v.size() ? &v[0] : nullptr; }
+
+}  // namespace
+
+double sum(const vec &v, unsigned threads) {
+    const double *x = begin(v);
+    return sum_terms(v.size(), threads, [x](size_t i) { return x[i]; });
+}
+
+double dot(const vec &lhs, const vec &rhs, unsigned threads) {
+    if (lhs.size() != rhs.size())
+        throw std::invalid_argument("ERROR: vecs have different sizes");
+    const double *x = begin(lhs), *y = begin(rhs);
+    // The base blocks use the SIMD dot product kernel
+    const auto kernel = simd_kernels().dot;
+    return reduce_sum(lhs.size(), threads, [&](size_t first, size_t last) {
+        return kernel(x + first, y + first, last - first);
+    });
+}
+
+double norm1(const vec &v, unsigned threads) {
+    const double *x = begin(v);
+    return sum_terms(v.size(), threads,
+                     [x](size_t i) { return std::abs(x[i]); });
+}
+
+double norm2(const vec &v, unsigned threads) {
+    return std::sqrt(dot(v, v, threads));
+}
+
+double norm_inf(const vec &v, unsigned threads) {
+    return fold(
+        v.size(), threads, 0.0,
+        [](double acc, double x) { return std::max(acc, std::abs(x)); },
+        begin(v));
+}
+
+double minimum(const vec &v, unsigned threads) {
+    if (v.size() == 0)
+        throw std::invalid_argument("ERROR: minimum of an empty vec");
+    return fold(
+        v.size(), threads, v[0],
+        [](double acc, double x) { return std::min(acc, x); }, begin(v));
+}
+
+double maximum(const vec &v, unsigned threads) {
+    if (v.size() == 0)
+        throw std::invalid_argument("ERROR: maximum of an empty vec");
+    return fold(
+        v.size(), threads, v[0],
+        [](double acc, double x) { return std::max(acc, x); }, begin(v));
+}
@@ -0,0 +1,40 @@
+#ifndef REDUCE_H_
+#define REDUCE_H_
+
+#include <cstddef>
+
+#include "vec.h"
+
+// --- Reductions over vecs
+//
+// The vec is cut into chunks of 'reduce_chunk' elements, which are spread
+// over 'threads' threads (0: one per hardware thread). Inside of a chunk the
+// elements are added up pairwise (the error grows with O(log n) instead of
+// O(n) for a plain loop), and the results of the chunks are added up pairwise
+// as well. The chunk size does not depend on the number of threads and every
+// partial result always ends up in the same place, so the result is bitwise
+// the same for any number of threads.
+
+/// Number of elements per chunk (the unit of work of one thread)
+constexpr size_t reduce_chunk = 1 << 15;
+
+/// Sum of all elements
+double sum(const vec &v, unsigned threads = 0);
+
+/// Scalar product. Throws std::invalid_argument if the sizes differ.
+double dot(const vec &lhs, const vec &rhs, unsigned threads = 0);
+
+/// Sum of the absolute values of the elements
+double norm1(const vec &v, unsigned threads = 0);
+
+/// Euclidean norm
+double norm2(const vec &v, unsigned threads = 0);
+
+/// Largest absolute value (0 for an empty vec)
+double norm_inf(const vec &v, unsigned threads = 0);
+
+/// Smallest/largest element. Throw std::invalid_argument for an empty vec.
+double minimum(const vec &v, unsigned threads = 0);
+double maximum(const vec &v, unsigned threads = 0);
+
+#endif  // REDUCE_H_
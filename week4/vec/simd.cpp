@@ -0,0 +1,222 @@
+#include "simd.h"
+
+// The AVX2 and AVX-512 kernels are compiled with the 'target' attribute, so
+// this file does not need -mavx2 and the program still runs on CPUs without
+// them: simd_kernels() checks at runtime which table may be used.
+#if defined(__x86_64__) || defined(__i386__)
+#define VEC_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Scalar kernels (fallback for every CPU)
+
+static void add_scalar(double *x, const double *y, size_t n) {
+    for (size_t i = 0; i < n; ++i) x[i] += y[i];
+}
+
+static void sub_scalar(double *x, const double *y, size_t n) {
+    for (size_t i = 0; i < n; ++i) x[i] -= y[i];
+}
+
+static void scale_scalar(double *x, double scale, size_t n) {
+    for (size_t i = 0; i < n; ++i) x[i] *= scale;
+}
+
+static double dot_scalar(const double *x, const double *y, size_t n) {
+    // Four independent accumulators hide the latency of the additions
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += x[i] * y[i];
+        s1 += x[i + 1] * y[i + 1];
+        s2 += x[i + 2] * y[i + 2];
+        s3 += x[i + 3] * y[i + 3];
+    }
+    for (; i < n; ++i) s0 += x[i] * y[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+#ifdef VEC_X86
+
+// Loads are unaligned on purpose: the kernels take raw pointers, which need
+// not point to the start of a vec. On aligned data (every vec) an unaligned
+// load is exactly as fast as an aligned one.
+
+// --- AVX2 kernels (4 doubles per register)
+
+__attribute__((target("avx2,fma"))) static void add_avx2(double *x,
+                                                        const double *y,
+                                                        size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d a0 = _mm256_loadu_pd(x + i), a1 = _mm256_loadu_pd(x + i + 4);
+        __m256d b0 = _mm256_loadu_pd(y + i), b1 = _mm256_loadu_pd(y + i + 4);
+        _mm256_storeu_pd(x + i, _mm256_add_pd(a0, b0));
+        _mm256_storeu_pd(x + i + 4, _mm256_add_pd(a1, b1));
+    }
+    for (; i < n; ++i) x[i] += y[i];
+}
+
+__attribute__((target("avx2,fma"))) static void sub_avx2(double *x,
+                                                        const double *y,
+                                                        size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d a0 = _mm256_loadu_pd(x + i), a1 = _mm256_loadu_pd(x + i + 4);
+        __m256d b0 = _mm256_loadu_pd(y + i), b1 = _mm256_loadu_pd(y + i + 4);
+        _mm256_storeu_pd(x + i, _mm256_sub_pd(a0, b0));
+        _mm256_storeu_pd(x + i + 4, _mm256_sub_pd(a1, b1));
+    }
+    for (; i < n; ++i) x[i] -= y[i];
+}
+
+__attribute__((target("avx2,fma"))) static void scale_avx2(double *x,
+                                                          double scale,
+                                                          size_t n) {
+    const __m256d s = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), s));
+        _mm256_storeu_pd(x + i + 4,
+                         _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), s));
+    }
+    for (; i < n; ++i) x[i] *= scale;
+}
+
+__attribute__((target("avx2,fma"))) static double dot_avx2(const double *x,
+                                                          const double *y,
+                                                          size_t n) {
+    // Four accumulators, so four FMAs are in flight at the same time
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i),
+                             s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4),
+                             _mm256_loadu_pd(y + i + 4), s1);
+        s2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8),
+                             _mm256_loadu_pd(y + i + 8), s2);
+        s3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12),
+                             _mm256_loadu_pd(y + i + 12), s3);
+    }
+    for (; i + 4 <= n; i += 4)
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i),
+                             s0);
+    __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+    __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s),
+                           _mm256_extractf128_pd(s, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    for (; i < n; ++i) sum += x[i] * y[i];
+    return sum;
+}
+
+// --- AVX-512 kernels (8 doubles per register)
+
+__attribute__((target("avx512f"))) static void add_avx512(double *x,
+                                                         const double *y,
+                                                         size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(x + i, _mm512_add_pd(_mm512_loadu_pd(x + i),
+                                              _mm512_loadu_pd(y + i)));
+    // The tail is done with a masked load/store instead of a scalar loop
+    if (i < n) {
+        __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d a = _mm512_maskz_loadu_pd(m, x + i);
+        __m512d b = _mm512_maskz_loadu_pd(m, y + i);
+        _mm512_mask_storeu_pd(x + i, m, _mm512_add_pd(a, b));
+    }
+}
+
+__attribute__((target("avx512f"))) static void sub_avx512(double *x,
+                                                         const double *y,
+                                                         size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(x + i, _mm512_sub_pd(_mm512_loadu_pd(x + i),
+                                              _mm512_loadu_pd(y + i)));
+    if (i < n) {
+        __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d a = _mm512_maskz_loadu_pd(m, x + i);
+        __m512d b = _mm512_maskz_loadu_pd(m, y + i);
+        _mm512_mask_storeu_pd(x + i, m, _mm512_sub_pd(a, b));
+    }
+}
+
+__attribute__((target("avx512f"))) static void scale_avx512(double *x,
+                                                           double scale,
+                                                           size_t n) {
+    const __m512d s = _mm512_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm512_storeu_pd(x + i, _mm512_mul_pd(_mm512_loadu_pd(x + i), s));
+    if (i < n) {
+        __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+        __m512d a = _mm512_maskz_loadu_pd(m, x + i);
+        _mm512_mask_storeu_pd(x + i, m, _mm512_mul_pd(a, s));
+    }
+}
+
+__attribute__((target("avx512f"))) static double dot_avx512(const double *x,
+                                                           const double *y,
+                                                           size_t n) {
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i),
+                             s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8),
+                             _mm512_loadu_pd(y + i + 8), s1);
+        s2 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 16),
+                             _mm512_loadu_pd(y + i + 16), s2);
+        s3 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 24),
+                             _mm512_loadu_pd(y + i + 24), s3);
+    }
+    for (; i + 8 <= n; i += 8)
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i),
+                             s0);
+    if (i < n) {
+        __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+        s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, x + i),
+                             _mm512_maskz_loadu_pd(m, y + i), s1);
+    }
+    // Horizontal sum through memory (_mm512_reduce_add_pd makes GCC 12 warn
+    // about an uninitialized variable in its own header)
+    alignas(64) double lane[8];
+    __m512d s = _mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3));
+    _mm512_store_pd(lane, s);
+    return ((lane[0] + lane[1]) + (lane[2] + lane[3])) +
+           ((lane[4] + lane[5]) + (lane[6] + lane[7]));
+}
+
+#endif  // VEC_X86
+
+// --- Dispatch
+
+static const simd_kernel_table scalar_table = {
+    "scalar", add_scalar, sub_scalar, scale_scalar, dot_scalar};
+
+#ifdef VEC_X86
+static const simd_kernel_table avx2_table = {"avx2", add_avx2, sub_avx2,
+                                             scale_avx2, dot_avx2};
+static const simd_kernel_table avx512_table = {"avx512", add_avx512, sub_avx512,
+                                               scale_avx512, dot_avx512};
+#endif
+
+static const simd_kernel_table &select_kernels() {
+#ifdef VEC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return avx512_table;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return avx2_table;
+#endif
+    return scalar_table;
+}
+
+const simd_kernel_table &simd_kernels() {
+    // Initialized once (thread-safe since C++11)
+    static const simd_kernel_table &table = select_kernels();
+    return table;
+}
@@ -0,0 +1,30 @@
+#ifndef SIMD_H_
+#define SIMD_H_
+
+#include <cstddef>
+
+// Alignment (in bytes) of the storage of every vec. 64 bytes is the width of
+// an AVX-512 register and of a cache line.
+constexpr size_t simd_alignment = 64;
+
+/// Table of the element-wise kernels used by vec. Every instruction set that
+/// is supported gets its own table, and simd_kernels() hands out the best one
+/// for the CPU the program is running on.
+struct simd_kernel_table {
+    /// Name of the instruction set ("scalar", "avx2" or "avx512")
+    const char *name;
+    /// x[i] += y[i] for i in [0, n)
+    void (*add)(double *x, const double *y, size_t n);
+    /// x[i] -= y[i] for i in [0, n)
+    void (*sub)(double *x, const double *y, size_t n);
+    /// x[i] *= scale for i in [0, n)
+    void (*scale)(double *x, double scale, size_t n);
+    /// Returns the sum of x[i] * y[i] for i in [0, n)
+    double (*dot)(const double *x, const double *y, size_t n);
+};
+
+/// Returns the kernels for the widest instruction set the CPU supports. The
+/// CPU is only queried on the first call.
+const simd_kernel_table &simd_kernels();
+
+#endif  // SIMD_H_
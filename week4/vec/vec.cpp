@@ -1,8 +1,66 @@
 #include "vec.h"
 
+#include <algorithm>  // std::copy
+
+#include "reduce.h"
+#include "simd.h"
+
+// --- Storage
+
+// Heap storage comes from 'resource' (see vec_memory.h). Like the inline
+// buffer 'local', it is aligned to 'simd_alignment' bytes, so that a vec
+// always starts at a cache line and SIMD loads never straddle two lines.
+
+void vec::allocate(size_t cap) {
+    if (cap <= small_size) {
+        data = local;
+        capacity_ = small_size;
+    } else {
+        data = static_cast<double *>(
+            resource->allocate(cap * sizeof(double), simd_alignment));
+        capacity_ = cap;
+    }
+}
+
+void vec::deallocate() {
+    if (data != local)
+        resource->deallocate(data, capacity_ * sizeof(double), simd_alignment);
+}
+
+void vec::reallocate(size_t cap) {
+    double *old = data;
+    size_t old_capacity = capacity_;
+    allocate(cap);
+    for (size_t i = 0; i < elements; ++i) data[i] = old[i];
+    if (old != local)
+        resource->deallocate(old, old_capacity * sizeof(double),
+                             simd_alignment);
+}
+
+void vec::steal(vec &v) {
+    elements = v.elements;
+    if (v.data == v.local) {
+        // Inline elements can't be taken over, but there are at most
+        // 'small_size' of them
+        data = local;
+        capacity_ = small_size;
+        for (size_t i = 0; i < elements; ++i) local[i] = v.local[i];
+    } else {
+        data = v.data;
+        capacity_ = v.capacity_;
+    }
+    v.elements = 0;
+    v.capacity_ = small_size;
+    v.data = v.local;
+}
+
 // --- Constructors
 
-vec::vec(size_t size) : elements(size), data(new double[size]) {}
+vec::vec() : elements(0), resource(vec_resource()) { allocate(0); }
+
+vec::vec(size_t size) : elements(size), resource(vec_resource()) {
+    allocate(size);
+}
 
 vec::vec(size_t size, double ival) : vec(size) {
     for (size_t i = 0; i < size; ++i) {
@@ -28,7 +86,7 @@ vec::vec(std::initializer_list<double> ilist)
 // --- Destructor
 
 vec::~vec() {
-    delete[] data;
+    deallocate();
     // we don't need to set data to null or elements to 0 here, since the object
     // will be destroyed immediately after this function anyway
     // (source: https://www.learncpp.com/cpp-tutorial/stdinitializer_list/)
@@ -36,7 +94,10 @@ vec::~vec() {
 
 // --- Copy/Move constructor/assignment operator
 
-vec::vec(const vec &v) : elements(v.elements), data(new double[elements]) {
+// A copy allocates from the resource that is current for this thread, not
+// from the one of 'v' (like the std::pmr containers do)
+vec::vec(const vec &v) : elements(v.elements), resource(vec_resource()) {
+    allocate(elements);
     for (size_t i = 0; i < elements; ++i) data[i] = v.data[i];
 }
 
@@ -44,37 +105,64 @@ vec &vec::operator=(const vec &v) {
     // If you are copying yourself
     if (this == &v) return *this;
 
+    // Reuse the current storage if it is big enough
+    if (v.elements > capacity_) {
+        // Free the current resources data is pointing at
+        // Do this before loosing the handle in the next line
+        deallocate();
+        data = local;
+        capacity_ = small_size;
+        elements = 0;
+        allocate(v.elements);
+    }
     elements = v.elements;
-    // Free the current resources data is pointing at
-    // Do this before loosing the handle in the next line
-    delete[] data;
-    data = new double[elements];
     for (size_t i = 0; i < elements; ++i) data[i] = v.data[i];
     return *this;
 }
 
-vec::vec(vec &&v) : elements(v.elements), data(v.data) { v.data = nullptr; }
+vec::vec(vec &&v) : resource(v.resource) { steal(v); }
 
 vec &vec::operator=(vec &&v) {
     // If you are copying yourself
     if (this == &v) return *this;
 
+    // Heap storage of 'v' can only be taken over if it would be given back
+    // to the same resource. Otherwise (e.g. 'v' lives in a vec_arena) copy
+    // it.
+    if (v.data != v.local && !resource->is_equal(*v.resource))
+        return *this = v;
+
     // First delete what ultimately will be thrown away
-    delete[] data;
-    data = v.data;
-    v.data = nullptr;
+    deallocate();
+    steal(v);
     return *this;
 }
 
-// --- Other methods
+// --- Capacity
 
-size_t vec::size() const { return elements; }
+void vec::reserve(size_t cap) {
+    if (cap > capacity_) reallocate(cap);
+}
 
-// --- Other Operators
+void vec::shrink_to_fit() {
+    if (data != local && elements < capacity_) reallocate(elements);
+}
+
+void vec::push_back(double value) {
+    // 'value' is a copy, so it stays valid even if it was an element of this
+    // vec and the storage moves
+    if (elements == capacity_) reallocate(2 * capacity_);
+    data[elements++] = value;
+}
 
-double &vec::operator[](size_t idx) { return data[idx]; }
+// --- Other methods
 
-const double &vec::operator[](size_t idx) const { return data[idx]; }
+void vec::check_size(size_t size) const {
+    if (size != elements)
+        throw std::invalid_argument("ERROR: vecs have different sizes");
+}
+
+// --- Other Operators
 
 std::ostream &operator<<(std::ostream &os, const vec &v) {
     for (size_t i = 0; i < v.size(); ++i) {
@@ -83,40 +171,53 @@ std::ostream &operator<<(std::ostream &os, const vec &v) {
     return os;
 }
 
-vec operator+(vec lhs, const vec &rhs) {
-    // Check two vector are of the same size. If not the same, return [-1]
-    if (lhs.size() != rhs.size()) return vec(1, -1.0);
+vec &vec::operator+=(const vec &rhs) {
+    check_size(rhs.elements);
+    simd_kernels().add(data, rhs.data, elements);
+    return *this;
+}
 
-    for (size_t i = 0; i < lhs.elements; ++i) {
-        lhs[i] += rhs[i];
-    }
-    return lhs;
+vec &vec::operator-=(const vec &rhs) {
+    check_size(rhs.elements);
+    simd_kernels().sub(data, rhs.data, elements);
+    return *this;
 }
 
-vec operator-(vec lhs, const vec &rhs) {
-    // Check two vector are of the same size. If not the same, return [-1]
-    if (lhs.size() != rhs.size()) return vec(1, -1.0);
+vec &vec::operator*=(double scale) {
+    simd_kernels().scale(data, scale, elements);
+    return *this;
+}
 
-    for (size_t i = 0; i < lhs.elements; ++i) {
-        lhs[i] -= rhs[i];
+void vec::evaluate(const vec_binary<vec, vec, vec_add> &expr) {
+    const vec &lhs = expr.left(), &rhs = expr.right();
+    // 'a = b + a' adds 'b' to itself
+    if (&rhs == this) {
+        simd_kernels().add(data, lhs.data, elements);
+        return;
     }
-    return lhs;
+    if (&lhs != this) std::copy(lhs.data, lhs.data + elements, data);
+    simd_kernels().add(data, rhs.data, elements);
 }
 
-vec operator*(vec lhs, double scale) {
-    for (size_t i = 0; i < lhs.elements; ++i) {
-        lhs[i] *= scale;
+void vec::evaluate(const vec_binary<vec, vec, vec_sub> &expr) {
+    const vec &lhs = expr.left(), &rhs = expr.right();
+    // 'a = b - a' would overwrite its right operand first
+    if (&rhs == this) {
+        for (size_t i = 0; i < elements; ++i) data[i] = lhs.data[i] - data[i];
+        return;
     }
-    return lhs;
+    if (&lhs != this) std::copy(lhs.data, lhs.data + elements, data);
+    simd_kernels().sub(data, rhs.data, elements);
 }
 
-double operator*(const vec &lhs, const vec &rhs) {
-    // Check two vector are of the same size
-    if (lhs.size() != rhs.size()) return -1.0;
+void vec::evaluate(const vec_scaled<vec> &expr) {
+    const vec &operand = expr.operand();
+    if (&operand != this)
+        std::copy(operand.data, operand.data + elements, data);
+    simd_kernels().scale(data, expr.factor(), elements);
+}
 
-    double product = 0;
-    for (size_t i = 0; i < lhs.elements; ++i) {
-        product += lhs[i] * rhs[i];
-    }
-    return product;
+double operator*(const vec &lhs, const vec &rhs) {
+    // Parallel for long vecs, and pairwise summed (see reduce.h)
+    return dot(lhs, rhs);
 }
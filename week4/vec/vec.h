@@ -3,21 +3,92 @@
 
 #include <initializer_list>
 #include <iostream>
+#include <memory_resource>
+#include <stdexcept>
 #include <utility>
 
-class vec {
+#include "simd.h"
+#include "vec_memory.h"
+
+// --- Expression templates
+//
+// 'a + b * 2 - c' does not compute anything by itself. Every operator returns
+// a small object which only remembers its operands, and the whole expression
+// is evaluated element by element in a single loop once it is assigned to a
+// vec. No temporary vec is created on the way. A single operation on two
+// vecs (or a vec and a scalar) is handed to the SIMD kernels of simd.h
+// instead.
+
+/// Base class of everything that can stand on the right hand side of a vec
+/// assignment (CRTP: 'E' is the derived class).
+template <typename E>
+struct vec_expr {
+    const E &self() const { return static_cast<const E &>(*this); }
+};
+
+class vec;
+template <typename L, typename R, typename Op>
+class vec_binary;
+template <typename E>
+class vec_scaled;
+struct vec_add;
+struct vec_sub;
+
+// How an operand is stored inside of an expression: vecs by reference (they
+// outlive the full expression), sub expressions by value (they are
+// temporaries).
+template <typename E>
+struct vec_operand {
+    using type = const E;
+};
+template <>
+struct vec_operand<vec> {
+    using type = const vec &;
+};
+
+class vec : public vec_expr<vec> {
+public:
+    /// Number of elements that fit into the vec itself. Up to that size no
+    /// memory is allocated at all.
+    static constexpr size_t small_size = 8;
+
 private:
     // Variable to store the number of elements contained in this vec.
     size_t elements;
-    // Pointer to store the address of the dynamically allocated memory.
+    // Number of elements that fit into 'data' before it has to grow.
+    size_t capacity_;
+    // The memory resource heap storage is allocated from (see vec_memory.h).
+    std::pmr::memory_resource *resource;
+    // Pointer to the elements: either 'local' or dynamically allocated memory
+    // that is aligned to 'simd_alignment' (see simd.h) bytes.
     double *data;
+    // Inline storage for small vecs (small buffer optimization).
+    alignas(simd_alignment) double local[small_size];
+
+    // Points 'data' to storage for 'cap' elements ('local' if they fit).
+    void allocate(size_t cap);
+    // Gives heap storage back to 'resource'.
+    void deallocate();
+    // Moves the elements to new storage for 'cap' (>= elements) elements.
+    void reallocate(size_t cap);
+    // Takes over the elements of 'v' (which has the same resource) and
+    // leaves it empty. The current storage must already be released.
+    void steal(vec &v);
 
 public:
     // --- Constructors
 
+    /// Creates an empty vec (using the inline buffer, so no allocation).
+    vec();
+
     /// Creates a vec variable of size 'size'.
-    /// This constructor has to allocate an array of 'size' double variables.
-    vec(size_t size);
+    /// This constructor has to allocate an array of 'size' double variables,
+    /// unless they fit into the inline buffer. Like every constructor, it
+    /// allocates from vec_resource(): the innermost vec_arena of this thread
+    /// or else the vec_pool().
+    /// It is explicit, so that 'v * 2' can not be mistaken for a scalar
+    /// product with vec(2).
+    explicit vec(size_t size);
 
     /// Creates a vec variable of size 'size' and to initialize all entires with
     /// the value of 'ival'. This constructor has to allocate an array of 'size'
@@ -28,6 +99,12 @@ public:
     /// Creates a vec variable with the contents of 'ilist'.
     vec(std::initializer_list<double> ilist);
 
+    /// Creates a vec variable by evaluating the expression 'e' in one pass.
+    template <typename E>
+    vec(const vec_expr<E> &e) : vec(e.self().size()) {
+        evaluate(e.self());
+    }
+
     // --- Destructor
 
     /// Deallocates the dynamically allocated heap memory.
@@ -42,48 +119,197 @@ public:
     vec &operator=(const vec &v);
 
     /// Move constructor that steals the data of the vec variable 'v'.
+    /// (Inline elements are copied, there are at most 'small_size' of them.)
     vec(vec &&v);
 
     /// Move assignment operator. Moves from the vector variable 'v'.
+    /// If 'v' was allocated from a different memory resource, its elements
+    /// are copied instead.
     vec &operator=(vec &&v);
 
+    /// Evaluates the expression 'e' in one pass and stores the result. The
+    /// storage is only reallocated if it is too small. 'e' may contain this
+    /// vec itself (e.g. 'a = a + b'), since element 'i' of the result only
+    /// depends on element 'i' of the operands.
+    template <typename E>
+    vec &operator=(const vec_expr<E> &e) {
+        const E &expr = e.self();
+        // If the size differs, this vec can't be part of 'e'
+        if (expr.size() > capacity_) return *this = vec(expr);
+        elements = expr.size();
+        evaluate(expr);
+        return *this;
+    }
+
     // --- Other methods
 
     /// Returns the number of elements of the vector.
-    size_t size() const;
+    /// (Defined in the class, so it can be inlined into expressions.)
+    size_t size() const { return elements; }
+
+    /// Returns the number of elements the vector can hold without allocating.
+    size_t capacity() const { return capacity_; }
+
+    /// Makes room for at least 'cap' elements.
+    void reserve(size_t cap);
+
+    /// Gives unused capacity back (moves back into the inline buffer if the
+    /// elements fit).
+    void shrink_to_fit();
+
+    /// Appends 'value'. The capacity doubles when it runs out, so appending
+    /// n elements costs amortized O(n).
+    void push_back(double value);
+
+    /// Appends an element constructed from 'args'.
+    template <typename... Args>
+    void emplace_back(Args &&...args) {
+        push_back(double(std::forward<Args>(args)...));
+    }
 
     // --- Operators
 
     /// Returns a reference to the value at position 'idx'.
     /// This function does not perform a range check.
-    double &operator[](size_t idx);
+    double &operator[](size_t idx) { return data[idx]; }
 
     /// Returns a reference to the value at position 'idx'.
     /// This function does not perform a range check.
     /// See the lecture sildes for the reason why we have to provide a const
     /// version of this operator as well.
-    const double &operator[](size_t idx) const;
+    const double &operator[](size_t idx) const { return data[idx]; }
+
+    /// Adds 'rhs' entry-wise to this vec in place (no allocation).
+    /// Throws std::invalid_argument if the sizes differ.
+    vec &operator+=(const vec &rhs);
+
+    /// Subtracts 'rhs' entry-wise from this vec in place (no allocation).
+    /// Throws std::invalid_argument if the sizes differ.
+    vec &operator-=(const vec &rhs);
+
+    /// Multiplies each entry with the value of 'scale' in place.
+    vec &operator*=(double scale);
+
+    /// Adds the expression 'rhs' in one pass (e.g. 'a += b * 2').
+    template <typename E>
+    vec &operator+=(const vec_expr<E> &rhs) {
+        const E &expr = rhs.self();
+        check_size(expr.size());
+        for (size_t i = 0; i < elements; ++i) data[i] += expr[i];
+        return *this;
+    }
+
+    /// Subtracts the expression 'rhs' in one pass.
+    template <typename E>
+    vec &operator-=(const vec_expr<E> &rhs) {
+        const E &expr = rhs.self();
+        check_size(expr.size());
+        for (size_t i = 0; i < elements; ++i) data[i] -= expr[i];
+        return *this;
+    }
 
     /// Writes the elements stored in the vec 'v' to the output stream 'os'.
     /// A variable of type vec can then be printed using std::cout << ...
     friend std::ostream &operator<<(std::ostream &os, const vec &v);
 
-    /// Performs an entry-wise addition. Since we pass 'lhs' by value (so we
-    /// create a copy of it), you can add 'rhs's entires to 'lhs' return it.
-    friend vec operator+(vec lhs, const vec &rhs);
+    /// Computes the scalar product of two vectors, same as dot() in reduce.h.
+    /// Throws std::invalid_argument if the sizes differ.
+    /// The scalar product and the compound operators with a vec operand use
+    /// the SIMD kernels of simd.h, picked at runtime for the CPU the program
+    /// runs on.
+    friend double operator*(const vec &lhs, const vec &rhs);
 
-    /// Performs an entry-wise substraction. Since we pass 'lhs' by value (so we
-    /// create a copy of it), you can subtract 'rhs's entires to 'lhs' and
-    /// return it.
-    friend vec operator-(vec lhs, const vec &rhs);
+private:
+    // Throws std::invalid_argument unless 'size' equals the size of this vec
+    void check_size(size_t size) const;
 
-    /// Multiplies each entry with the value of 'scale'.
-    /// Since we pass 'lhs' by value (so we create a copy of it), you can
-    /// multiply each of it's entries by 'scale' and return it.
-    friend vec operator*(vec lhs, double scale);
+    // Stores the 'elements' entries of 'expr'. A single operation on vecs
+    // ('a + b', 'a - b', 'a * s') goes to the SIMD kernels like the compound
+    // operators do, longer expressions are fused into one scalar loop.
+    template <typename E>
+    void evaluate(const E &expr) {
+        for (size_t i = 0; i < elements; ++i) data[i] = expr[i];
+    }
+    void evaluate(const vec_binary<vec, vec, vec_add> &expr);
+    void evaluate(const vec_binary<vec, vec, vec_sub> &expr);
+    void evaluate(const vec_scaled<vec> &expr);
+};
 
-    /// Computes the scalar product of two vectors.
-    friend double operator*(const vec &lhs, const vec &rhs);
+// --- Expression nodes
+
+/// Entry-wise 'lhs op rhs' of two expressions of the same size.
+template <typename L, typename R, typename Op>
+class vec_binary : public vec_expr<vec_binary<L, R, Op>> {
+    typename vec_operand<L>::type lhs;
+    typename vec_operand<R>::type rhs;
+
+public:
+    vec_binary(const L &l, const R &r) : lhs(l), rhs(r) {
+        // Report size errors where they happen instead of returning a
+        // sentinel value
+        if (l.size() != r.size())
+            throw std::invalid_argument("ERROR: vecs have different sizes");
+    }
+    size_t size() const { return lhs.size(); }
+    double operator[](size_t i) const { return Op::apply(lhs[i], rhs[i]); }
+    const L &left() const { return lhs; }
+    const R &right() const { return rhs; }
+};
+
+/// Every entry of 'e' multiplied with 'scale'
+template <typename E>
+class vec_scaled : public vec_expr<vec_scaled<E>> {
+    typename vec_operand<E>::type e;
+    double scale;
+
+public:
+    vec_scaled(const E &e, double scale) : e(e), scale(scale) {}
+    size_t size() const { return e.size(); }
+    double operator[](size_t i) const { return e[i] * scale; }
+    const E &operand() const { return e; }
+    double factor() const { return scale; }
+};
+
+struct vec_add {
+    static double apply(double a, double b) { return a + b; }
+};
+struct vec_sub {
+    static double apply(double a, double b) { return a - b; }
 };
 
+// --- Operators on expressions
+
+/// Performs an entry-wise addition (evaluated lazily, see above).
+template <typename L, typename R>
+vec_binary<L, R, vec_add> operator+(const vec_expr<L> &lhs,
+                                    const vec_expr<R> &rhs) {
+    return vec_binary<L, R, vec_add>(lhs.self(), rhs.self());
+}
+
+/// Performs an entry-wise substraction (evaluated lazily, see above).
+template <typename L, typename R>
+vec_binary<L, R, vec_sub> operator-(const vec_expr<L> &lhs,
+                                    const vec_expr<R> &rhs) {
+    return vec_binary<L, R, vec_sub>(lhs.self(), rhs.self());
+}
+
+/// Multiplies each entry with the value of 'scale' (evaluated lazily).
+template <typename E>
+vec_scaled<E> operator*(const vec_expr<E> &lhs, double scale) {
+    return vec_scaled<E>(lhs.self(), scale);
+}
+
+template <typename E>
+vec_scaled<E> operator*(double scale, const vec_expr<E> &rhs) {
+    return vec_scaled<E>(rhs.self(), scale);
+}
+
+/// Writes the entries of an expression to 'os', like the operator<< of vec.
+template <typename E>
+std::ostream &operator<<(std::ostream &os, const vec_expr<E> &e) {
+    const E &expr = e.self();
+    for (size_t i = 0; i < expr.size(); ++i) os << expr[i] << " ";
+    return os;
+}
+
 #endif  // VEC_H_
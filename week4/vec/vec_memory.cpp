@@ -0,0 +1,183 @@
+#include "vec_memory.h"
+
+#include <algorithm>  // std::max
+#include <mutex>
+#include <new>  // std::align_val_t
+
+#include "simd.h"
+
+namespace {
+
+// Size classes: 64 bytes << i for i in [0, num_classes), i.e. 64 B ... 1 MiB
+constexpr size_t min_block = 64;
+constexpr size_t num_classes = 15;
+constexpr size_t max_block = min_block << (num_classes - 1);
+// A thread keeps at most this many free blocks per class before it hands
+// half of them over to the global lists
+constexpr unsigned max_cached = 64;
+// New blocks are carved out of chunks of (at least) this size
+constexpr size_t chunk_size = 256 * 1024;
+
+// A free block stores the pointer to the next free block in itself
+struct free_block {
+    free_block *next;
+};
+
+// Index of the smallest class that fits 'bytes' (ceil(log2(bytes)) - 6)
+size_t size_class(size_t bytes) {
+    if (bytes <= min_block) return 0;
+    return 64 - __builtin_clzll(bytes - 1) - 6;
+}
+
+// Blocks that are shared by all threads (refills and spills of the thread
+// caches). Allocated once and never destroyed, so it is still there when the
+// threads exit.
+struct global_lists {
+    std::mutex lock;
+    free_block *head[num_classes] = {};
+};
+
+global_lists &globals() {
+    static global_lists *lists = new global_lists();
+    return *lists;
+}
+
+// The free lists of one thread. It is trivially destructible, so it stays
+// usable even while the thread is shutting down; 'reaper' below moves its
+// blocks to the global lists when the thread exits.
+struct thread_cache {
+    free_block *head[num_classes];
+    unsigned count[num_classes];
+    bool registered;
+    bool dead;
+};
+
+thread_local thread_cache cache;
+
+void push_global(size_t cls, free_block *first, free_block *last) {
+    global_lists &g = globals();
+    std::lock_guard<std::mutex> guard(g.lock);
+    last->next = g.head[cls];
+    g.head[cls] = first;
+}
+
+// Moves the first 'n' blocks of the cache list 'cls' to the global list
+void spill(size_t cls, unsigned n) {
+    free_block *first = cache.head[cls], *last = first;
+    for (unsigned i = 1; i < n; ++i) last = last->next;
+    cache.head[cls] = last->next;
+    cache.count[cls] -= n;
+    push_global(cls, first, last);
+}
+
+struct cache_reaper {
+    ~cache_reaper() {
+        for (size_t cls = 0; cls < num_classes; ++cls)
+            if (cache.count[cls]) spill(cls, cache.count[cls]);
+        cache.dead = true;
+    }
+};
+
+thread_local cache_reaper reaper;
+
+// Makes sure the reaper of this thread is constructed (thread_local objects
+// with a destructor are only created when they are first used)
+void register_thread() {
+    if (!cache.registered) {
+        cache.registered = true;
+        static_cast<void>(&reaper);
+    }
+}
+
+// Fills the (empty) cache list 'cls', from the global list if possible and
+// from a new chunk otherwise
+void refill(size_t cls) {
+    const size_t block = min_block << cls;
+    {
+        global_lists &g = globals();
+        std::lock_guard<std::mutex> guard(g.lock);
+        for (unsigned i = 0; i < max_cached / 2 && g.head[cls]; ++i) {
+            free_block *b = g.head[cls];
+            g.head[cls] = b->next;
+            b->next = cache.head[cls];
+            cache.head[cls] = b;
+            ++cache.count[cls];
+        }
+    }
+    if (cache.head[cls]) return;
+
+    // Chunks are never freed; their blocks circulate between the lists
+    const size_t bytes = std::max(chunk_size, 4 * block);
+    char *chunk = static_cast<char *>(
+        ::operator new(bytes, std::align_val_t(simd_alignment)));
+    for (size_t offset = 0; offset + block <= bytes; offset += block) {
+        free_block *b = reinterpret_cast<free_block *>(chunk + offset);
+        b->next = cache.head[cls];
+        cache.head[cls] = b;
+        ++cache.count[cls];
+    }
+}
+
+class pool_resource : public std::pmr::memory_resource {
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        if (bytes > max_block || alignment > min_block)
+            return ::operator new(bytes, std::align_val_t(std::max(
+                                             alignment, simd_alignment)));
+        register_thread();
+        const size_t cls = size_class(bytes);
+        if (!cache.head[cls]) refill(cls);
+        free_block *b = cache.head[cls];
+        cache.head[cls] = b->next;
+        --cache.count[cls];
+        return b;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+        if (bytes > max_block || alignment > min_block) {
+            ::operator delete(
+                p, std::align_val_t(std::max(alignment, simd_alignment)));
+            return;
+        }
+        const size_t cls = size_class(bytes);
+        free_block *b = static_cast<free_block *>(p);
+        if (cache.dead) {
+            // The thread is exiting and its cache has already been flushed
+            push_global(cls, b, b);
+            return;
+        }
+        register_thread();
+        b->next = cache.head[cls];
+        cache.head[cls] = b;
+        if (++cache.count[cls] > max_cached) spill(cls, max_cached / 2);
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// The resource of the innermost vec_arena of this thread (if any)
+thread_local std::pmr::memory_resource *current_arena = nullptr;
+
+}  // namespace
+
+std::pmr::memory_resource *vec_pool() {
+    // Never destroyed: vecs with static storage duration may still give their
+    // memory back after main() returned
+    static pool_resource *pool = new pool_resource();
+    return pool;
+}
+
+std::pmr::memory_resource *vec_resource() {
+    return current_arena ? current_arena : vec_pool();
+}
+
+vec_arena::vec_arena(size_t initial_size)
+    : buffer(initial_size, std::pmr::new_delete_resource()),
+      previous(current_arena) {
+    current_arena = &buffer;
+}
+
+vec_arena::~vec_arena() { current_arena = previous; }
+
+void vec_arena::release() { buffer.release(); }
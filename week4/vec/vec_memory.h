@@ -0,0 +1,61 @@
+#ifndef VEC_MEMORY_H_
+#define VEC_MEMORY_H_
+
+#include <cstddef>
+#include <memory_resource>
+
+// --- Memory for vecs
+//
+// Every vec remembers the std::pmr::memory_resource its storage came from and
+// gives it back there. By default that is vec_pool(), a size-class pool with
+// a free list per thread, so short lived temporaries reuse the blocks of the
+// ones that died before them instead of calling operator new.
+//
+// Inside the scope of a vec_arena, new vecs of that thread are carved out of
+// one growing buffer instead, and everything is released at once when the
+// arena ends (e.g. once per frame).
+
+/// The thread-caching size-class pool. Requests are rounded up to a power of
+/// two between 64 bytes and 1 MiB; bigger ones go to operator new directly.
+/// Every thread keeps its own free lists, so the common path takes no lock.
+/// A block may be freed on any thread. Memory is kept for reuse and never
+/// returned to the operating system.
+std::pmr::memory_resource *vec_pool();
+
+/// Returns the memory resource that new vecs of this thread allocate from:
+/// the innermost live vec_arena, or vec_pool() if there is none.
+std::pmr::memory_resource *vec_resource();
+
+/// Frame/arena allocation mode. While a vec_arena is alive, vecs created on
+/// the same thread allocate from it with a pointer bump, freeing them costs
+/// nothing, and the whole arena is released in one go by its destructor (or
+/// by release()).
+///
+/// A vec that lives in an arena must not outlive it. Copy it (the copy
+/// allocates from the resource that is current at that point) to keep it.
+///
+///     {
+///         vec_arena frame;
+///         vec tmp = a + b;  // from the arena
+///         result = tmp;     // copied into result's own storage
+///     }                     // tmp's memory is released here
+class vec_arena {
+public:
+    /// 'initial_size' is the size of the first buffer in bytes; the arena
+    /// grows geometrically if it is exceeded.
+    explicit vec_arena(size_t initial_size = 1 << 20);
+    ~vec_arena();
+
+    vec_arena(const vec_arena &) = delete;
+    vec_arena &operator=(const vec_arena &) = delete;
+
+    /// Releases everything allocated from the arena so far. All vecs that
+    /// were allocated from it must be dead (or never be used again).
+    void release();
+
+private:
+    std::pmr::monotonic_buffer_resource buffer;
+    std::pmr::memory_resource *previous;
+};
+
+#endif  // VEC_MEMORY_H_
@@ -0,0 +1,217 @@
+// Benchmark of the list types against std::vector.
+//
+// Containers:
+//   - List: the pooled list from list.h, nodes in the order of creation
+//   - shuffled nodes: a plain chain of Nodes that are linked in a random
+//     order, as after many inserts and erases in a long-living list. Walking
+//     it misses the cache on almost every node.
+//   - UnrolledList<int, 64>
+//   - std::vector<int>
+//
+// Operations (time per element, best of several runs):
+//   - build:  append n elements
+//   - sum:    walk over all elements
+//   - find:   search the last element
+//   - insert: insert 1000 elements in the middle and erase them again (time
+//             per insert + erase; the lists get an iterator to the middle)
+//
+// Results: see bench_util.h (default CSV file: bench_list.csv).
+//
+// Usage: ./bench_list [--sizes 1000,100000] [--csv FILE]
+
+#include <algorithm>  // std::shuffle, std::find
+#include <cstdlib>    // std::strtoul
+#include <cstring>    // std::strcmp
+#include <fstream>    // std::ofstream
+#include <iostream>
+#include <random>  // std::mt19937
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "list.h"
+#include "unrolled_list.h"
+
+struct options {
+    std::vector<size_t> sizes = {1000, 100000, 10000000};
+    std::string csv = "bench_list.csv";
+};
+
+// Results go here, so the compiler cannot drop the work
+volatile long long sink;
+
+const int middle_inserts = 1000;
+
+// --- The containers
+
+long long sumNodes(const Node *n) {
+    long long sum = 0;
+    for (; n != nullptr; n = n->next) sum += n->data;
+    return sum;
+}
+
+const Node *findNode(const Node *n, int value) {
+    while (n != nullptr && n->data != value) n = n->next;
+    return n;
+}
+
+// A chain of the values 0 .. n-1 whose nodes are linked in a random order
+struct ShuffledNodes {
+    std::vector<Node *> nodes;
+    Node *head = nullptr;
+
+    explicit ShuffledNodes(size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            nodes.push_back(new Node(0));
+        std::vector<Node *> order = nodes;
+        std::shuffle(order.begin(), order.end(), std::mt19937(42));
+        for (size_t i = 0; i + 1 < n; ++i) order[i]->next = order[i + 1];
+        if (n > 0) order[n - 1]->next = nullptr;
+        for (size_t i = 0; i < n; ++i) order[i]->data = static_cast<int>(i);
+        head = n > 0 ? order[0] : nullptr;
+    }
+    ~ShuffledNodes() {
+        for (Node *n : nodes) delete n;
+    }
+};
+
+void bench(const options &opt, report &results) {
+    for (size_t n : opt.sizes) {
+        if (n == 0) continue;
+        const int last = static_cast<int>(n) - 1;
+        auto add = [&](const std::string &container,
+                       const std::string &operation, double seconds,
+                       size_t elements) {
+            results.add({container, operation, n, seconds / elements * 1e9});
+        };
+
+        // build
+        add("List", "build", best_time([&] {
+                List list;
+                return seconds([&] {
+                    for (int i = 0; i <= last; ++i) list.append(i);
+                });
+            }), n);
+        add("UnrolledList", "build", best_time([&] {
+                UnrolledList<int> list;
+                return seconds([&] {
+                    for (int i = 0; i <= last; ++i) list.push_back(i);
+                });
+            }), n);
+        add("std::vector", "build", best_time([&] {
+                std::vector<int> v;
+                return seconds([&] {
+                    for (int i = 0; i <= last; ++i) v.push_back(i);
+                });
+            }), n);
+
+        List list;
+        ShuffledNodes shuffled(n);
+        UnrolledList<int> unrolled;
+        std::vector<int> vec;
+        for (int i = 0; i <= last; ++i) {
+            list.append(i);
+            unrolled.push_back(i);
+            vec.push_back(i);
+        }
+
+        // sum
+        add("List", "sum", best_time([&] {
+                return seconds([&] { sink = sumNodes(list.head()); });
+            }), n);
+        add("shuffled nodes", "sum", best_time([&] {
+                return seconds([&] { sink = sumNodes(shuffled.head); });
+            }), n);
+        add("UnrolledList", "sum", best_time([&] {
+                return seconds([&] {
+                    long long sum = 0;
+                    unrolled.forEachBlock([&](const int *elems, size_t k) {
+                        for (size_t i = 0; i < k; ++i) sum += elems[i];
+                    });
+                    sink = sum;
+                });
+            }), n);
+        add("std::vector", "sum", best_time([&] {
+                return seconds([&] {
+                    long long sum = 0;
+                    for (int x : vec) sum += x;
+                    sink = sum;
+                });
+            }), n);
+
+        // find
+        add("List", "find", best_time([&] {
+                return seconds(
+                    [&] { sink = findNode(list.head(), last)->data; });
+            }), n);
+        add("shuffled nodes", "find", best_time([&] {
+                return seconds(
+                    [&] { sink = findNode(shuffled.head, last)->data; });
+            }), n);
+        add("UnrolledList", "find", best_time([&] {
+                return seconds([&] { sink = *unrolled.find(last); });
+            }), n);
+        add("std::vector", "find", best_time([&] {
+                return seconds(
+                    [&] { sink = *std::find(vec.begin(), vec.end(), last); });
+            }), n);
+
+        // insert in the middle
+        UnrolledList<int>::iterator middle = unrolled.begin();
+        for (size_t i = 0; i < n / 2; ++i) ++middle;
+        add("UnrolledList", "insert", best_time([&] {
+                return seconds([&] {
+                    UnrolledList<int>::iterator it = middle;
+                    for (int i = 0; i < middle_inserts; ++i)
+                        it = unrolled.insert(it, i);
+                    for (int i = 0; i < middle_inserts; ++i)
+                        it = unrolled.erase(it);
+                    middle = it;
+                });
+            }), middle_inserts);
+        add("std::vector", "insert", best_time([&] {
+                return seconds([&] {
+                    for (int i = 0; i < middle_inserts; ++i)
+                        vec.insert(vec.begin() + vec.size() / 2, i);
+                    for (int i = 0; i < middle_inserts; ++i)
+                        vec.erase(vec.begin() + vec.size() / 2);
+                });
+            }), middle_inserts);
+    }
+}
+
+std::vector<size_t> parse_sizes(const std::string &list) {
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');)
+        sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+    return sizes;
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc)
+            opt.sizes = parse_sizes(argv[++i]);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+            opt.csv = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--sizes 1000,100000] [--csv FILE]\n";
+            return 1;
+        }
+    }
+
+    std::ofstream csv;
+    if (!open_csv(csv, opt.csv)) return 1;
+
+    report results({{"container", "container", 16, true},
+                    {"operation", "operation", 11, true},
+                    {"n", "n", 10, false},
+                    {"ns_per_element", "ns/elem", 14, false}});
+    bench(opt, results);
+    results.write(csv, std::cout);
+
+    return 0;
+}
@@ -0,0 +1,284 @@
+// Contention benchmark of the queues in concurrent_queue.h.
+//
+// For 1 to N producers, each queue transports the same number of items from
+// the producers to one consumer (p:1) or to as many consumers as there are
+// producers (p:p):
+//   - locked list: a std::list guarded by a std::mutex, the usual way to hand
+//     over work items
+//   - MpscQueue: the items are nodes that the producers allocate up front
+//   - MpmcRing with 1024 cells
+//
+// Threads that find the queue empty (or the ring full) yield, so the
+// benchmark also works with more threads than cores. Reported are the items
+// per second and the time per item, and whether every item arrived exactly
+// once (and, with one consumer, in the order of its producer).
+//
+// Results: see bench_util.h (default CSV file: bench_queue.csv).
+//
+// Usage: ./bench_queue [--producers N] [--items N] [--csv FILE]
+
+#include <algorithm>  // std::max, std::min
+#include <cstdint>    // uint64_t
+#include <cstdlib>    // std::strtoul
+#include <cstring>    // std::strcmp
+#include <fstream>    // std::ofstream
+#include <iostream>
+#include <list>
+#include <memory>  // std::unique_ptr
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "concurrent_queue.h"
+
+struct options {
+    unsigned producers = std::max(4u, std::thread::hardware_concurrency());
+    size_t items = 1000000;  // in total, over all producers
+    std::string csv = "bench_queue.csv";
+};
+
+// A row of the report
+std::vector<cell> result(const std::string &queue, unsigned producers,
+                         unsigned consumers, size_t items, double seconds,
+                         bool ok) {
+    const double ns = seconds / items * 1e9;
+    return {queue, producers, consumers, items, 1e3 / ns, ns,
+            ok ? "ok" : "FAIL"};
+}
+
+// An item is the number of its producer and its position in the sequence of
+// items of that producer
+uint64_t makeItem(unsigned producer, uint64_t seq) {
+    return static_cast<uint64_t>(producer) << 40 | seq;
+}
+unsigned producerOf(uint64_t item) { return static_cast<unsigned>(item >> 40); }
+uint64_t seqOf(uint64_t item) { return item & ((uint64_t(1) << 40) - 1); }
+
+// Checks what the consumers received: every item exactly once, and the items
+// of each producer in the order in which it pushed them (with one consumer
+// exactly in that order). Every consumer has its own part, so they do not
+// need to synchronize; ok() puts the parts together afterwards.
+class Checker {
+public:
+    Checker(unsigned producers, unsigned consumers, size_t per_producer)
+        : producers(producers),
+          per_producer(per_producer),
+          parts(consumers, Part(producers, producers * per_producer)) {}
+
+    void received(unsigned consumer, uint64_t item) {
+        Part &part = parts[consumer];
+        const unsigned p = producerOf(item);
+        const uint64_t seq = seqOf(item);
+        if (p >= producers || seq >= per_producer || seq < part.next[p] ||
+            (parts.size() == 1 && seq != part.next[p])) {
+            part.valid = false;
+            return;
+        }
+        part.next[p] = seq + 1;
+        const size_t bit = p * per_producer + seq;
+        part.seen[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+
+    bool ok() const {
+        const size_t items = producers * per_producer;
+        for (const Part &part : parts)
+            if (!part.valid) return false;
+        // Every item in exactly one part
+        for (size_t w = 0; w * 64 < items; ++w) {
+            uint64_t all = 0;
+            for (const Part &part : parts) {
+                if ((all & part.seen[w]) != 0) return false;
+                all |= part.seen[w];
+            }
+            const size_t bits = std::min<size_t>(64, items - w * 64);
+            if (all != (bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    // The consumers write to their parts all the time. A part, and the
+    // arrays it owns, end with a cache line of padding, so no two of them
+    // share a cache line (the parts are not alignas(cache_line): std::vector
+    // does not align beyond max_align_t before C++17).
+    struct Part {
+        static const size_t padding_words = cache_line / sizeof(uint64_t);
+
+        Part(unsigned producers, size_t items)
+            : next(producers + padding_words, 0),
+              seen((items + 63) / 64 + padding_words, 0) {}
+
+        std::vector<uint64_t> next;  // per producer: seq of the next item
+        std::vector<uint64_t> seen;  // bit p * per_producer + seq: arrived
+        bool valid = true;  // no item out of range or out of order
+        char padding[cache_line];
+    };
+
+    unsigned producers;
+    size_t per_producer;
+    std::vector<Part> parts;
+};
+
+// Runs the producer and consumer threads (see run_threads()) and returns the
+// seconds until the last item arrived. produce(p, n) and consume(c, count) are
+// the bodies of the threads; 'count' is the number of items that consumer c
+// has to take, so all items are taken.
+template <typename Produce, typename Consume>
+double run(unsigned producers, unsigned consumers, size_t per_producer,
+           Produce produce, Consume consume) {
+    const size_t total = producers * per_producer;
+    return run_threads(producers + consumers, [&](unsigned t) {
+        if (t < producers) {
+            produce(t, per_producer);
+        } else {
+            const unsigned c = t - producers;
+            consume(c, total / consumers + (c < total % consumers ? 1 : 0));
+        }
+    });
+}
+
+// --- The queues
+
+std::vector<cell> benchLockedList(unsigned producers, unsigned consumers,
+                           size_t per_producer) {
+    std::mutex mutex;
+    std::list<uint64_t> queue;
+    Checker checker(producers, consumers, per_producer);
+    const double seconds = run(
+        producers, consumers, per_producer,
+        [&](unsigned p, size_t n) {
+            for (size_t s = 0; s < n; ++s) {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(makeItem(p, s));
+            }
+        },
+        [&](unsigned c, size_t count) {
+            for (size_t i = 0; i < count;) {
+                uint64_t item = 0;
+                bool found = false;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!queue.empty()) {
+                        item = queue.front();
+                        queue.pop_front();
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                checker.received(c, item);
+                ++i;
+            }
+        });
+    return result("locked list", producers, consumers, producers * per_producer,
+                  seconds, checker.ok());
+}
+
+struct Item : MpscNode {
+    uint64_t value;
+};
+
+std::vector<cell> benchMpsc(unsigned producers, size_t per_producer) {
+    MpscQueue queue;
+    // Nodes hold atomics and cannot be copied into a vector
+    std::vector<std::unique_ptr<Item[]>> items;
+    for (unsigned p = 0; p < producers; ++p)
+        items.emplace_back(new Item[per_producer]);
+    Checker checker(producers, 1, per_producer);
+    const double seconds = run(
+        producers, 1, per_producer,
+        [&](unsigned p, size_t n) {
+            for (size_t s = 0; s < n; ++s) {
+                items[p][s].value = makeItem(p, s);
+                queue.push(&items[p][s]);
+            }
+        },
+        [&](unsigned, size_t count) {
+            for (size_t i = 0; i < count;) {
+                MpscNode *n = queue.pop();
+                if (n == nullptr) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                checker.received(0, static_cast<Item *>(n)->value);
+                ++i;
+            }
+        });
+    return result("MpscQueue", producers, 1, producers * per_producer, seconds,
+                  checker.ok());
+}
+
+std::vector<cell> benchRing(unsigned producers, unsigned consumers,
+                     size_t per_producer) {
+    MpmcRing<uint64_t> ring(1024);
+    Checker checker(producers, consumers, per_producer);
+    const double seconds = run(
+        producers, consumers, per_producer,
+        [&](unsigned p, size_t n) {
+            for (size_t s = 0; s < n; ++s)
+                while (!ring.tryPush(makeItem(p, s))) std::this_thread::yield();
+        },
+        [&](unsigned c, size_t count) {
+            for (size_t i = 0; i < count;) {
+                uint64_t item;
+                if (!ring.tryPop(item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                checker.received(c, item);
+                ++i;
+            }
+        });
+    return result("MpmcRing", producers, consumers, producers * per_producer,
+                  seconds, checker.ok());
+}
+
+void bench(const options &opt, report &results) {
+    for (unsigned p = 1; p <= opt.producers; ++p) {
+        const size_t per_producer = std::max<size_t>(1, opt.items / p);
+        results.add(benchLockedList(p, 1, per_producer));
+        results.add(benchMpsc(p, per_producer));
+        results.add(benchRing(p, 1, per_producer));
+        if (p > 1) {
+            results.add(benchLockedList(p, p, per_producer));
+            results.add(benchRing(p, p, per_producer));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--producers") && i + 1 < argc)
+            opt.producers = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--items") && i + 1 < argc)
+            opt.items = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+            opt.csv = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--producers N] [--items N] [--csv FILE]\n";
+            return 1;
+        }
+    }
+
+    std::ofstream csv;
+    if (!open_csv(csv, opt.csv)) return 1;
+
+    report results({{"queue", "queue", 13, true},
+                    {"producers", "producers", 11, false},
+                    {"consumers", "consumers", 11, false},
+                    {"items", "items", 10, false},
+                    {"mitems_per_second", "Mitems/s", 10, false},
+                    {"ns_per_item", "ns/item", 10, false},
+                    {"ok", "check", 7, false}});
+    bench(opt, results);
+    results.write(csv, std::cout);
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Scalability benchmark of SkipList against a std::map behind a mutex.
+//
+// For 1 to N threads, both maps go through the same phases. The n keys (even
+// numbers in random order) are split evenly between the threads:
+//   - insert: every thread inserts its keys
+//   - lookup: every thread looks up its keys and as many missing (odd) keys
+//   - scan:   every thread scans ranges of about 100 keys, n/100 in total
+//   - erase:  every thread erases its keys
+// Reported are the operations per second (for scans: keys visited per second)
+// and whether the maps held what they should.
+//
+// Results: see bench_util.h (default CSV file: bench_skiplist.csv).
+//
+// Usage: ./bench_skiplist [--threads N] [--keys N] [--csv FILE]
+
+#include <algorithm>  // std::shuffle, std::max
+#include <atomic>
+#include <cstdlib>  // std::strtoul
+#include <cstring>  // std::strcmp
+#include <fstream>  // std::ofstream
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>  // std::mt19937
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "skip_list.h"
+
+struct options {
+    unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+    size_t keys = 1000000;
+    std::string csv = "bench_skiplist.csv";
+};
+
+const long scan_width = 200;  // about 100 keys, every other number is a key
+
+// std::map with one lock around everything, the interface of SkipList
+class LockedMap {
+public:
+    bool insert(long key, long value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return map.insert(std::make_pair(key, value)).second;
+    }
+    bool erase(long key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return map.erase(key) == 1;
+    }
+    bool find(long key, long &value) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = map.find(key);
+        if (it == map.end()) return false;
+        value = it->second;
+        return true;
+    }
+    template <typename F>
+    size_t scan(long from, long to, F f) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t calls = 0;
+        for (auto it = map.lower_bound(from); it != map.end() && it->first < to;
+             ++it, ++calls)
+            f(it->first, it->second);
+        return calls;
+    }
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return map.size();
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::map<long, long> map;
+};
+
+template <typename Map>
+void phases(const std::string &name, unsigned threads,
+            const std::vector<long> &keys, report &results) {
+    // A row of the report
+    auto add = [&](const std::string &phase, size_t operations, double seconds,
+                   bool ok) {
+        results.add({name, phase, threads, operations,
+                     operations / seconds / 1e6, ok ? "ok" : "FAIL"});
+    };
+    Map map;
+    const size_t n = keys.size();
+    // Keys of thread t: keys[first(t) .. first(t + 1))
+    auto first = [&](unsigned t) { return n * t / threads; };
+    std::atomic<size_t> hits(0), successes(0), visited(0);
+
+    double seconds = run_threads(threads, [&](unsigned t) {
+        size_t ok = 0;
+        for (size_t i = first(t); i < first(t + 1); ++i)
+            ok += map.insert(keys[i], keys[i] / 2);
+        successes += ok;
+    });
+    add("insert", n, seconds, successes == n && map.size() == n);
+
+    seconds = run_threads(threads, [&](unsigned t) {
+        size_t found = 0;
+        long value;
+        for (size_t i = first(t); i < first(t + 1); ++i) {
+            found += map.find(keys[i], value) && value == keys[i] / 2;
+            found += map.find(keys[i] + 1, value);
+        }
+        hits += found;
+    });
+    add("lookup", 2 * n, seconds, hits == n);
+
+    const size_t scans = std::max<size_t>(1, n / 100);
+    seconds = run_threads(threads, [&](unsigned t) {
+        size_t count = 0;
+        long sum = 0;
+        for (size_t s = scans * t / threads; s < scans * (t + 1) / threads;
+             ++s) {
+            const long from = keys[s * 97 % n];
+            count += map.scan(from, from + scan_width,
+                              [&](long key, long) { sum += key; });
+        }
+        visited += count + (sum == -1);  // keep 'sum' alive
+    });
+    add("scan", visited, seconds, visited >= scans);
+
+    successes = 0;
+    seconds = run_threads(threads, [&](unsigned t) {
+        size_t ok = 0;
+        for (size_t i = first(t); i < first(t + 1); ++i)
+            ok += map.erase(keys[i]);
+        successes += ok;
+    });
+    add("erase", n, seconds, successes == n && map.size() == 0);
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+            opt.threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--keys") && i + 1 < argc)
+            opt.keys = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+            opt.csv = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--threads N] [--keys N] [--csv FILE]\n";
+            return 1;
+        }
+    }
+    if (opt.keys == 0) opt.keys = 1;
+
+    std::ofstream csv;
+    if (!open_csv(csv, opt.csv)) return 1;
+
+    std::vector<long> keys(opt.keys);
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = 2 * static_cast<long>(i);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+    report results({{"map", "map", 17, true},
+                    {"phase", "phase", 8, true},
+                    {"threads", "threads", 9, false},
+                    {"operations", "operations", 12, false},
+                    {"mops_per_second", "Mops/s", 10, false},
+                    {"ok", "check", 7, false}});
+    for (unsigned t = 1; t <= opt.threads; ++t) {
+        phases<SkipList<long, long>>("SkipList", t, keys, results);
+        phases<LockedMap>("locked std::map", t, keys, results);
+    }
+    results.write(csv, std::cout);
+
+    return 0;
+}
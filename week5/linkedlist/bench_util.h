@@ -0,0 +1,141 @@
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+#include <algorithm>  // std::min
+#include <atomic>
+#include <chrono>  // Timing capabilities
+#include <fstream>  // std::ofstream
+#include <iomanip>  // std::setw
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>  // std::enable_if, std::is_integral
+#include <vector>
+
+// --- What the benchmarks of this directory share
+//
+// Every benchmark collects its results in a report, which prints them as a
+// human readable table to stdout and writes the same data as CSV to the file
+// given with '--csv'.
+
+// Seconds that f() takes
+template <typename F>
+double seconds(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Runs 'f' until at least 'min_time' seconds have passed and returns the
+// fastest run. 'f' returns the time of the part of its work that counts.
+template <typename F>
+double best_time(F f, double min_time = 0.2, int min_runs = 3) {
+    double best = 1e300, total = 0;
+    for (int run = 0; run < min_runs || total < min_time; ++run) {
+        const double t = f();
+        best = std::min(best, t);
+        total += t;
+    }
+    return best;
+}
+
+// Runs body(t) for t in [0, threads) on as many threads, which start at the
+// same time, and returns the seconds until all of them are done. If a thread
+// cannot be started, the others return without running 'body' and the error
+// is rethrown.
+template <typename F>
+double run_threads(unsigned threads, F body) {
+    std::atomic<bool> go(false), cancelled(false);
+    std::vector<std::thread> pool;
+    try {
+        for (unsigned t = 0; t < threads; ++t)
+            pool.emplace_back([&, t] {
+                while (!go.load()) std::this_thread::yield();
+                if (!cancelled.load()) body(t);
+            });
+    } catch (...) {
+        cancelled.store(true);
+        go.store(true);
+        for (auto &thread : pool) thread.join();
+        throw;
+    }
+    return seconds([&] {
+        go.store(true);
+        for (auto &thread : pool) thread.join();
+    });
+}
+
+// A column of a report: its name in the CSV header and the table, and its
+// width in the table
+struct column {
+    std::string csv_name;
+    std::string title;
+    int width;
+    bool left;  // aligned to the left (text) or to the right (numbers)
+};
+
+// One value of a row: text, or a number. The table shows fractional numbers
+// with two decimals, the CSV file with all of them.
+struct cell {
+    cell(const std::string &text) : text(text) {}
+    cell(const char *text) : text(text) {}
+    cell(double number) : number(number), fractional(true) {}
+    template <typename T, typename = typename std::enable_if<
+                              std::is_integral<T>::value>::type>
+    cell(T number) : text(std::to_string(number)) {}
+
+    std::string text;
+    double number = 0;
+    bool fractional = false;
+};
+
+class report {
+public:
+    explicit report(std::vector<column> columns) : columns(columns) {}
+
+    void add(std::vector<cell> row) { rows.push_back(row); }
+
+    void write(std::ostream &csv, std::ostream &table) const {
+        for (size_t c = 0; c < columns.size(); ++c) {
+            csv << (c > 0 ? "," : "") << columns[c].csv_name;
+            align(table, columns[c]) << columns[c].title;
+        }
+        csv << '\n';
+        table << '\n';
+        for (const auto &row : rows) {
+            for (size_t c = 0; c < columns.size(); ++c) {
+                const cell &value = row[c];
+                if (c > 0) csv << ',';
+                align(table, columns[c]);
+                if (value.fractional) {
+                    csv << value.number;
+                    table << std::fixed << std::setprecision(2) << value.number;
+                } else {
+                    csv << value.text;
+                    table << value.text;
+                }
+            }
+            csv << '\n';
+            table << '\n';
+        }
+    }
+
+private:
+    static std::ostream &align(std::ostream &os, const column &c) {
+        return os << (c.left ? std::left : std::right) << std::setw(c.width);
+    }
+
+    std::vector<column> columns;
+    std::vector<std::vector<cell>> rows;
+};
+
+// Opens the CSV file for a report. Prints an error and returns false if it
+// cannot be written.
+inline bool open_csv(std::ofstream &csv, const std::string &filename) {
+    csv.open(filename);
+    if (!csv) std::cerr << "Could not open the file " << filename << '\n';
+    return static_cast<bool>(csv);
+}
+
+#endif  // BENCH_UTIL_H_
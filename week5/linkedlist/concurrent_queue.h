@@ -0,0 +1,171 @@
+#ifndef CONCURRENT_QUEUE_H_
+#define CONCURRENT_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// --- Lock-free queues for handing work between threads
+//
+// MpscQueue: any number of producers, one consumer, unbounded. It is
+// intrusive like the Node list: the elements are nodes with a 'next' pointer
+// that the caller allocates (e.g. from a NodePool-like slab) and embeds in its
+// own type by deriving from MpscNode. A push is one atomic exchange and one
+// store, whatever the number of producers.
+//
+// MpmcRing: any number of producers and consumers, bounded. A fixed array of
+// cells, each with a sequence number that says whose turn it is. Pushes and
+// pops claim a cell with a compare-and-swap on a shared counter.
+//
+// Memory reclamation: neither queue needs hazard pointers or epochs. A
+// producer of the MpscQueue only ever touches the node it pushes and the node
+// that was the last one before, and the consumer does not return that one
+// before the producer has linked the new node to it (until then the node's
+// 'next' is null and pop() reports the queue as empty). So once pop() returns
+// a node, no other thread will access it and it can be freed or reused right
+// away. The MpmcRing never allocates or frees during operation at all.
+//
+// Both algorithms are by Dmitry Vyukov [1, 2].
+
+// Size of a cache line; counters that different threads write are kept on
+// separate lines so the threads do not steal them from each other
+const size_t cache_line = 64;
+
+struct MpscNode {
+    std::atomic<MpscNode *> next;
+    MpscNode() : next(nullptr) {}
+};
+
+class MpscQueue {
+public:
+    MpscQueue() : back(&stub), front(&stub) {}
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /// Appends 'n'. Can be called by any thread.
+    void push(MpscNode *n) {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode *prev = back.exchange(n, std::memory_order_acq_rel);
+        // Between the exchange and this store the queue is cut in two and
+        // the consumer cannot get past 'prev'
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    /// Removes and returns the first node, nullptr if the queue is empty or
+    /// a producer is halfway through pushing the next node. Only one thread
+    /// at a time may call pop().
+    MpscNode *pop() {
+        MpscNode *first = front;
+        MpscNode *next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            // The stub only marks the front of an empty queue: skip it
+            if (next == nullptr) return nullptr;
+            front = first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            front = next;
+            return first;
+        }
+        // 'first' is the last node. It can only be returned when another node
+        // follows it, so put the stub behind it.
+        if (first != back.load(std::memory_order_acquire)) return nullptr;
+        push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next == nullptr) return nullptr;
+        front = next;
+        return first;
+    }
+
+private:
+    alignas(cache_line) std::atomic<MpscNode *> back;  // producers
+    alignas(cache_line) MpscNode *front;               // consumer
+    MpscNode stub;
+};
+
+template <typename T>
+class MpmcRing {
+public:
+    /// 'capacity' is rounded up to a power of two (at least 2)
+    explicit MpmcRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        push_pos.store(0, std::memory_order_relaxed);
+        pop_pos.store(0, std::memory_order_relaxed);
+    }
+    MpmcRing(const MpmcRing &) = delete;
+    MpmcRing &operator=(const MpmcRing &) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    /// Appends 'value' unless the ring is full
+    bool tryPush(T value) {
+        size_t pos = push_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                // The cell is free in this round: try to claim it
+                if (push_pos.compare_exchange_weak(pos, pos + 1,
+                                                   std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;  // the cell still holds the previous round
+            } else {
+                pos = push_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Removes the first element into 'value' unless the ring is empty
+    bool tryPop(T &value) {
+        size_t pos = pop_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t diff =
+                static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (pop_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;  // nothing pushed into the cell yet
+            } else {
+                pos = pop_pos.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        // Free for the push one round later
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(cache_line) std::atomic<size_t> push_pos;
+    alignas(cache_line) std::atomic<size_t> pop_pos;
+};
+
+// Refs:
+// [1] http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+// [2] http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+#endif  // CONCURRENT_QUEUE_H_
@@ -12,17 +12,7 @@
 
 #include <iostream>
 
-struct Node {
-    int data;
-    Node *next;
-    Node(int i) : data(i), next(nullptr) {}
-    friend std::ostream &operator<<(std::ostream &os, const Node &n) {
-        os << "Node\n"
-           << "\tdata: " << n.data << "\n\tthis: " << &n
-           << "\n\tnext: " << n.next;
-        return os;
-    }
-};
+#include "list.h"
 
 void addElement(Node **head, int data) {
     Node *n = new Node(data);
@@ -51,17 +41,13 @@ void printList(const Node *head) {
 }
 
 void deleteList(Node *head) {
-    // if it's an empty list then do nothing
-    if (head == nullptr) return;
-
-    // If the list contains only one element
-    if (head->next == nullptr) {
+    // A loop instead of a recursion: one stack frame per node overflows the
+    // stack for long lists
+    while (head != nullptr) {
+        Node *next = head->next;
         delete head;
-        return;
+        head = next;
     }
-
-    deleteList(head->next);
-    delete head;
 }
 
 int main() {
@@ -72,5 +58,20 @@ int main() {
     addElement(&list, 4);
     printList(list);
     deleteList(list);
+
+    // The same with O(1) appends and pooled nodes
+    List pooled;
+    for (int i = 1; i <= 4; ++i) pooled.append(i);
+    printList(pooled.head());
+
+    // Long lists: deleteList() no longer runs out of stack, and a pooled list
+    // frees its nodes slab by slab
+    const int n = 10000000;
+    Node *big = new Node(0), *last = big;
+    for (int i = 1; i < n; ++i) last = last->next = new Node(i);
+    deleteList(big);
+    for (int i = 0; i < n; ++i) pooled.append(i);
+    pooled.clear();
+    std::cout << "freed two lists of " << n << " nodes\n";
     return 0;
 }
@@ -0,0 +1,141 @@
+#ifndef LIST_H_
+#define LIST_H_
+
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <vector>
+
+struct Node {
+    int data;
+    Node *next;
+    Node(int i) : data(i), next(nullptr) {}
+    friend std::ostream &operator<<(std::ostream &os, const Node &n) {
+        os << "Node\n"
+           << "\tdata: " << n.data << "\n\tthis: " << &n
+           << "\n\tnext: " << n.next;
+        return os;
+    }
+};
+
+// --- Pooled nodes
+//
+// A NodePool hands out nodes from slabs, i.e. big blocks of memory that hold
+// many nodes each, instead of allocating every node on its own. Nodes that
+// are created one after the other lie next to each other in memory, which
+// makes walking the list cache friendly, and there is one allocation per slab
+// instead of one per node. Destroyed nodes go to a free list and are reused
+// by the next create(). release() frees all nodes at once: it only touches
+// the slabs, not the nodes, so it costs O(number of slabs).
+
+class NodePool {
+public:
+    explicit NodePool(size_t nodes_per_slab = 1024)
+        : nodes_per_slab(nodes_per_slab > 0 ? nodes_per_slab : 1) {}
+    ~NodePool() { release(); }
+    NodePool(const NodePool &) = delete;
+    NodePool &operator=(const NodePool &) = delete;
+
+    Node *create(int data) {
+        Node *n;
+        if (free_list != nullptr) {
+            n = free_list;
+            free_list = free_list->next;
+        } else {
+            if (next == end) grow();
+            n = next++;
+        }
+        return new (n) Node(data);
+    }
+
+    /// Returns 'n' to the pool; it must come from this pool
+    void destroy(Node *n) {
+        // Nodes are trivially destructible, the memory just becomes free
+        n->next = free_list;
+        free_list = n;
+    }
+
+    /// Frees all nodes of the pool at once
+    void release() {
+        for (Node *slab : slabs) ::operator delete(slab);
+        slabs.clear();
+        next = end = free_list = nullptr;
+    }
+
+    size_t slabCount() const { return slabs.size(); }
+
+private:
+    void grow() {
+        next = static_cast<Node *>(
+            ::operator new(nodes_per_slab * sizeof(Node)));
+        slabs.push_back(next);
+        end = next + nodes_per_slab;
+    }
+
+    size_t nodes_per_slab;
+    std::vector<Node *> slabs;
+    Node *next = nullptr;  // first unused node in the newest slab
+    Node *end = nullptr;   // end of the newest slab
+    Node *free_list = nullptr;
+};
+
+// --- List with O(1) append
+//
+// Keeps a pointer to its last node, so appending does not have to walk the
+// whole list like addElement() does, and takes its nodes from its own pool.
+// The nodes form an ordinary chain starting at head(), so the functions for
+// plain lists like printList() work on it as well.
+
+class List {
+public:
+    explicit List(size_t nodes_per_slab = 1024) : pool(nodes_per_slab) {}
+    List(const List &) = delete;
+    List &operator=(const List &) = delete;
+
+    void append(int data) {
+        Node *n = pool.create(data);
+        if (last == nullptr)
+            first = n;
+        else
+            last->next = n;
+        last = n;
+        ++count;
+    }
+
+    void prepend(int data) {
+        Node *n = pool.create(data);
+        n->next = first;
+        first = n;
+        if (last == nullptr) last = n;
+        ++count;
+    }
+
+    /// Removes the first element; the list must not be empty
+    void removeFirst() {
+        Node *n = first;
+        first = n->next;
+        if (first == nullptr) last = nullptr;
+        pool.destroy(n);
+        --count;
+    }
+
+    /// Removes all elements in O(number of slabs)
+    void clear() {
+        pool.release();
+        first = last = nullptr;
+        count = 0;
+    }
+
+    const Node *head() const { return first; }
+    const Node *tail() const { return last; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    NodePool pool;
+    Node *first = nullptr;
+    Node *last = nullptr;
+    size_t count = 0;
+};
+
+#endif  // LIST_H_
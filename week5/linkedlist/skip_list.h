@@ -0,0 +1,497 @@
+#ifndef SKIP_LIST_H_
+#define SKIP_LIST_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// --- Concurrent ordered map
+//
+// A skip list is a sorted linked list with express lanes: every node is in
+// the list of level 0, about half of them also in level 1, a quarter in
+// level 2 and so on. A search starts in the highest level and goes down
+// whenever the next node would overshoot, which takes O(log n) steps.
+//
+// SkipList is the "lazy" concurrent skip list of Herlihy et al. [1]:
+//   - find(), contains() and scan() take no locks at all.
+//   - insert() and erase() lock only the predecessors of the node on each
+//     of its levels (plus the node itself), validate that nothing changed
+//     in between and retry otherwise. Updates in different parts of the
+//     list do not block each other.
+//   - A node is logically in the map once it is linked on all of its levels
+//     ('linked') and until it is marked for deletion ('marked').
+//
+// Tower layout: a node and the 'next' pointers of all its levels are one
+// block of memory, allocated from an arena of big chunks. A search mostly
+// reads the key and the next pointer of a node, which are on the same cache
+// line, and allocating a node is a pointer bump.
+//
+// Memory reclamation: readers may still be looking at a node when it is
+// erased, so an erased node is only unlinked and retired. Every operation
+// pins the current epoch while it runs, and a retired node is recycled for a
+// later insert once no thread can be pinned to an epoch in which it was still
+// reachable (epoch based reclamation [2]). The memory of a map with heavy
+// churn stays bounded as long as no thread stays inside an operation (a long
+// scan(), say) forever.
+//
+// Keys and values are immutable once inserted. Key needs operator< (or a
+// Compare); Key and Value must be default constructible (for the head
+// sentinel) and copy constructible.
+
+namespace skip_list_detail {
+
+// Small spin lock (one byte instead of the 40 of a std::mutex). Yields to
+// other threads while waiting, so it also works with more threads than cores.
+class SpinLock {
+public:
+    void lock() {
+        while (flag.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    void unlock() { flag.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+const size_t stripe_count = 16;
+
+// The stripe of the calling thread among stripe_count
+inline size_t threadStripe() {
+    return std::hash<std::thread::id>()(std::this_thread::get_id()) %
+           stripe_count;
+}
+
+// Hands out memory from big chunks. There are several independent stripes;
+// a thread uses the one picked by its id, so threads rarely wait for each
+// other. Everything is freed at once by the destructor.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena() {
+        for (Stripe &s : stripes)
+            for (char *chunk : s.chunks) ::operator delete(chunk);
+    }
+
+    void *allocate(size_t bytes, size_t align) {
+        Stripe &s = stripes[threadStripe()];
+        std::lock_guard<std::mutex> lock(s.mutex);
+        size_t offset = (s.used + align - 1) / align * align;
+        if (s.chunks.empty() || offset + bytes > s.size) {
+            s.size = bytes > chunk_size ? bytes : chunk_size;
+            s.chunks.push_back(static_cast<char *>(::operator new(s.size)));
+            offset = 0;
+        }
+        s.used = offset + bytes;
+        return s.chunks.back() + offset;
+    }
+
+private:
+    static const size_t chunk_size = 1 << 16;
+
+    struct Stripe {
+        std::mutex mutex;
+        std::vector<char *> chunks;
+        size_t size = 0;  // of the newest chunk
+        size_t used = 0;  // bytes of the newest chunk in use
+    };
+    Stripe stripes[stripe_count];
+};
+
+}  // namespace skip_list_detail
+
+template <typename Key, typename Value, typename Compare = std::less<Key>>
+class SkipList {
+public:
+    /// Levels 0 .. max_height - 1; enough for about 2^max_height keys
+    static const int max_height = 24;
+
+    explicit SkipList(Compare less = Compare())
+        : less(less), head(newNode(Key(), Value(), max_height)) {}
+
+    ~SkipList() {
+        // Key and value of all nodes, in the map or erased, need their
+        // destructors; the memory goes with the arena
+        Node *n = head;
+        while (n != nullptr) {
+            Node *next = n->next(0).load(std::memory_order_relaxed);
+            n->~Node();
+            n = next;
+        }
+        for (std::atomic<Node *> &list : garbage)
+            for (n = list.load(); n != nullptr;) {
+                Node *next = n->retired_next;
+                n->~Node();
+                n = next;
+            }
+    }
+
+    SkipList(const SkipList &) = delete;
+    SkipList &operator=(const SkipList &) = delete;
+
+    /// Number of keys; only exact while no update is running
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    /// Inserts 'key' with 'value' unless 'key' is already in the map.
+    /// Returns whether it inserted.
+    bool insert(const Key &key, const Value &value) {
+        const Pin pin(*this);
+        const int height = randomHeight();
+        Node *preds[max_height], *succs[max_height];
+        for (;;) {
+            const int found = findNode(key, preds, succs);
+            if (found != -1) {
+                Node *n = succs[found];
+                if (!n->marked.load(std::memory_order_acquire)) {
+                    // Wait until the other insert is complete, so the key
+                    // is really in the map when we return
+                    while (!n->linked.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+                    return false;
+                }
+                // Being erased: try again once it is gone
+                std::this_thread::yield();
+                continue;
+            }
+
+            int locked = -1;
+            bool valid = true;
+            for (int level = 0; valid && level < height; ++level) {
+                Node *pred = preds[level], *succ = succs[level];
+                if (level == 0 || pred != preds[level - 1]) pred->lock.lock();
+                locked = level;
+                valid = !pred->marked.load(std::memory_order_acquire) &&
+                        (succ == nullptr ||
+                         !succ->marked.load(std::memory_order_acquire)) &&
+                        pred->next(level).load(std::memory_order_acquire) ==
+                            succ;
+            }
+            if (!valid) {
+                unlockPreds(preds, locked);
+                continue;
+            }
+
+            Node *n = newNode(key, value, height);
+            for (int level = 0; level < height; ++level)
+                n->next(level).store(succs[level], std::memory_order_relaxed);
+            for (int level = 0; level < height; ++level)
+                preds[level]->next(level).store(n, std::memory_order_release);
+            n->linked.store(true, std::memory_order_release);
+            unlockPreds(preds, locked);
+            count.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    /// Removes 'key'. Returns whether it was in the map.
+    bool erase(const Key &key) {
+        const Pin pin(*this);
+        Node *preds[max_height], *succs[max_height];
+        Node *victim = nullptr;
+        bool marked = false;
+        for (;;) {
+            const int found = findNode(key, preds, succs);
+            if (!marked) {
+                if (found == -1) return false;
+                victim = succs[found];
+                // Only a node that is completely linked and found on its top
+                // level can be erased (otherwise it is still being inserted
+                // or another erase was faster)
+                if (!victim->linked.load(std::memory_order_acquire) ||
+                    victim->height - 1 != found ||
+                    victim->marked.load(std::memory_order_acquire))
+                    return false;
+                victim->lock.lock();
+                if (victim->marked.load(std::memory_order_relaxed)) {
+                    victim->lock.unlock();
+                    return false;
+                }
+                // From here on the key is not in the map anymore
+                victim->marked.store(true, std::memory_order_release);
+                marked = true;
+            }
+
+            int locked = -1;
+            bool valid = true;
+            for (int level = 0; valid && level < victim->height; ++level) {
+                Node *pred = preds[level];
+                if (level == 0 || pred != preds[level - 1]) pred->lock.lock();
+                locked = level;
+                valid = !pred->marked.load(std::memory_order_acquire) &&
+                        pred->next(level).load(std::memory_order_acquire) ==
+                            victim;
+            }
+            if (!valid) {
+                unlockPreds(preds, locked);
+                continue;
+            }
+
+            for (int level = victim->height - 1; level >= 0; --level)
+                preds[level]->next(level).store(
+                    victim->next(level).load(std::memory_order_relaxed),
+                    std::memory_order_release);
+            victim->lock.unlock();
+            unlockPreds(preds, locked);
+            retire(victim, pin.epoch);
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    bool contains(const Key &key) const {
+        const Pin pin(*this);
+        return lookup(key) != nullptr;
+    }
+
+    /// Copies the value of 'key' to 'value'. Returns false if 'key' is not in
+    /// the map.
+    bool find(const Key &key, Value &value) const {
+        const Pin pin(*this);
+        const Node *n = lookup(key);
+        if (n == nullptr) return false;
+        value = n->value;
+        return true;
+    }
+
+    /// Calls f(key, value) for the keys in [from, to) in ascending order.
+    /// Concurrent updates may or may not be seen. Returns the number of calls.
+    template <typename F>
+    size_t scan(const Key &from, const Key &to, F f) const {
+        const Pin pin(*this);
+        // Last node before 'from', level by level
+        const Node *n = head;
+        for (int level = max_height - 1; level >= 0; --level) {
+            const Node *next = n->next(level).load(std::memory_order_acquire);
+            while (next != nullptr && less(next->key, from)) {
+                n = next;
+                next = n->next(level).load(std::memory_order_acquire);
+            }
+        }
+        size_t calls = 0;
+        for (n = n->next(0).load(std::memory_order_acquire);
+             n != nullptr && less(n->key, to);
+             n = n->next(0).load(std::memory_order_acquire)) {
+            if (n->linked.load(std::memory_order_acquire) &&
+                !n->marked.load(std::memory_order_acquire)) {
+                f(n->key, n->value);
+                ++calls;
+            }
+        }
+        return calls;
+    }
+
+private:
+    // The 'next' pointers of the node's levels follow the node directly in
+    // memory (see newNode()), hence the alignment
+    struct alignas(std::atomic<void *>) Node {
+        Node(const Key &key, const Value &value, int height)
+            : key(key), value(value), height(height) {}
+
+        std::atomic<Node *> &next(int level) {
+            return reinterpret_cast<std::atomic<Node *> *>(this + 1)[level];
+        }
+        const std::atomic<Node *> &next(int level) const {
+            return reinterpret_cast<const std::atomic<Node *> *>(
+                this + 1)[level];
+        }
+
+        const Key key;
+        const Value value;
+        const int height;
+        std::atomic<bool> marked{false};  // erased
+        std::atomic<bool> linked{false};  // linked on all levels
+        skip_list_detail::SpinLock lock;
+        Node *retired_next = nullptr;  // in the garbage of its epoch
+    };
+
+    // Counts the operations running in one epoch, for one stripe of threads.
+    // Padded to a cache line, so the stripes do not share one.
+    struct Readers {
+        std::atomic<long> count{0};
+        char padding[64 - sizeof(std::atomic<long>)];
+    };
+
+    // Pins the current epoch for the lifetime of an operation: no node that
+    // the operation can reach is recycled before the Pin is gone
+    class Pin {
+    public:
+        explicit Pin(const SkipList &list) {
+            const size_t stripe = skip_list_detail::threadStripe();
+            for (;;) {
+                epoch = list.epoch.load();
+                readers = &list.readers[epoch % 3][stripe].count;
+                readers->fetch_add(1);
+                // The epoch may have moved on before we were counted
+                if (list.epoch.load() == epoch) break;
+                readers->fetch_sub(1);
+            }
+        }
+        ~Pin() { readers->fetch_sub(1); }
+
+        Pin(const Pin &) = delete;
+        Pin &operator=(const Pin &) = delete;
+
+        uint64_t epoch;
+
+    private:
+        std::atomic<long> *readers;
+    };
+
+    Node *newNode(const Key &key, const Value &value, int height) {
+        void *memory = nullptr;
+        if (recycled.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<skip_list_detail::SpinLock> lock(free_lock);
+            std::vector<void *> &nodes = free_nodes[height];
+            if (!nodes.empty()) {
+                memory = nodes.back();
+                nodes.pop_back();
+                recycled.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        if (memory == nullptr)
+            memory = arena.allocate(
+                sizeof(Node) + height * sizeof(std::atomic<Node *>),
+                alignof(Node));
+        Node *n = new (memory) Node(key, value, height);
+        for (int level = 0; level < height; ++level)
+            new (&n->next(level)) std::atomic<Node *>(nullptr);
+        return n;
+    }
+
+    // Fills in the predecessor and successor of 'key' on every level and
+    // returns the highest level on which a node with 'key' was found (-1 if
+    // none)
+    int findNode(const Key &key, Node **preds, Node **succs) const {
+        int found = -1;
+        Node *pred = head;
+        for (int level = max_height - 1; level >= 0; --level) {
+            Node *curr = pred->next(level).load(std::memory_order_acquire);
+            while (curr != nullptr && less(curr->key, key)) {
+                pred = curr;
+                curr = pred->next(level).load(std::memory_order_acquire);
+            }
+            if (found == -1 && curr != nullptr && !less(key, curr->key))
+                found = level;
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return found;
+    }
+
+    const Node *lookup(const Key &key) const {
+        const Node *pred = head;
+        for (int level = max_height - 1; level >= 0; --level) {
+            const Node *curr = pred->next(level).load(std::memory_order_acquire);
+            while (curr != nullptr && less(curr->key, key)) {
+                pred = curr;
+                curr = pred->next(level).load(std::memory_order_acquire);
+            }
+            if (curr != nullptr && !less(key, curr->key))
+                return curr->linked.load(std::memory_order_acquire) &&
+                               !curr->marked.load(std::memory_order_acquire)
+                           ? curr
+                           : nullptr;
+        }
+        return nullptr;
+    }
+
+    // Unlocks the distinct predecessors on the levels 0 .. 'locked'
+    static void unlockPreds(Node **preds, int locked) {
+        for (int level = 0; level <= locked; ++level)
+            if (level == 0 || preds[level] != preds[level - 1])
+                preds[level]->lock.unlock();
+    }
+
+    // Puts an erased node into the garbage of the epoch its erase pinned,
+    // and every reclaim_batch nodes tries to recycle older garbage
+    void retire(Node *n, uint64_t pinned) {
+        std::atomic<Node *> &list = garbage[pinned % 3];
+        n->retired_next = list.load(std::memory_order_relaxed);
+        while (!list.compare_exchange_weak(n->retired_next, n,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        }
+        if (retired.fetch_add(1, std::memory_order_relaxed) % reclaim_batch ==
+            reclaim_batch - 1)
+            reclaim();
+    }
+
+    // Moves the epoch from e to e + 1 if every pinned operation is in e, and
+    // recycles the nodes retired in e - 2. Those were unlinked before the
+    // epoch became e (their erase kept it from moving on), so only
+    // operations pinned in e - 2 or e - 1 may still see them, and there are
+    // none.
+    void reclaim() {
+        std::unique_lock<std::mutex> lock(reclaim_mutex, std::try_to_lock);
+        if (!lock) return;
+        const uint64_t e = epoch.load();
+        for (const Readers &stripe : readers[(e + 2) % 3])
+            if (stripe.count.load() != 0) return;
+        // Nobody pins e - 2 anymore, so nobody adds to its garbage, which is
+        // the list the operations of e + 1 will use
+        Node *n = garbage[(e + 1) % 3].exchange(nullptr);
+        epoch.store(e + 1);
+
+        std::lock_guard<skip_list_detail::SpinLock> free(free_lock);
+        while (n != nullptr) {
+            Node *next = n->retired_next;
+            const int height = n->height;
+            n->~Node();
+            free_nodes[height].push_back(n);
+            recycled.fetch_add(1, std::memory_order_relaxed);
+            n = next;
+        }
+    }
+
+    // Height h with probability 2^-h
+    static int randomHeight() {
+        // xorshift, one state per thread
+        static thread_local uint64_t state =
+            std::hash<std::thread::id>()(std::this_thread::get_id()) |
+            1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int height = 1;
+        for (uint64_t bits = state; (bits & 1) && height < max_height;
+             bits >>= 1)
+            ++height;
+        return height;
+    }
+
+    Compare less;
+    skip_list_detail::Arena arena;
+
+    // Epoch based reclamation: operations running in epoch e are counted in
+    // readers[e % 3], nodes erased in it wait in garbage[e % 3]
+    static const size_t reclaim_batch = 64;
+    std::atomic<uint64_t> epoch{0};
+    mutable Readers readers[3][skip_list_detail::stripe_count];
+    std::atomic<Node *> garbage[3] = {{nullptr}, {nullptr}, {nullptr}};
+    std::atomic<size_t> retired{0};  // nodes erased so far
+    std::mutex reclaim_mutex;
+
+    // Memory of recycled nodes by height, for newNode() (which also creates
+    // 'head', so all of this comes before it)
+    skip_list_detail::SpinLock free_lock;
+    std::vector<void *> free_nodes[max_height + 1];
+    std::atomic<size_t> recycled{0};  // in free_nodes
+
+    Node *head;  // sentinel with key 'minus infinity' on all levels
+    std::atomic<size_t> count{0};
+};
+
+// Refs:
+// [1] M. Herlihy, Y. Lev, V. Luchangco, N. Shavit: A Simple Optimistic
+//     Skiplist Algorithm. SIROCCO 2007.
+// [2] K. Fraser: Practical lock-freedom. PhD thesis, University of
+//     Cambridge, 2004.
+
+#endif  // SKIP_LIST_H_
@@ -0,0 +1,263 @@
+#ifndef UNROLLED_LIST_H_
+#define UNROLLED_LIST_H_
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+// --- Unrolled linked list
+//
+// A linked list of blocks that hold up to K elements each in an array. A walk
+// over the list touches one block per K elements instead of one node per
+// element, and the elements of a block lie next to each other, so scans over
+// a block are plain loops over an array that the compiler can vectorize.
+//
+// Inserting and erasing at an iterator move at most K elements within one
+// block (plus a split or merge with the next block), which is O(1) for a fixed
+// K. Blocks in the middle of the list are kept at least half full.
+//
+// T has to be default constructible; K should be at least 2.
+
+template <typename T, size_t K = 64>
+class UnrolledList {
+    static_assert(K >= 2, "blocks must hold at least 2 elements");
+
+    struct Block {
+        Block *prev = nullptr;
+        Block *next = nullptr;
+        size_t count = 0;
+        T elems[K];
+    };
+
+public:
+    template <bool Const>
+    class basic_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<Const, const T *, T *>::type;
+        using reference =
+            typename std::conditional<Const, const T &, T &>::type;
+
+        basic_iterator() = default;
+        // iterator converts to const_iterator
+        template <bool C,
+                  typename = typename std::enable_if<Const && !C>::type>
+        basic_iterator(const basic_iterator<C> &other)
+            : block(other.block), index(other.index) {}
+
+        reference operator*() const { return block->elems[index]; }
+        pointer operator->() const { return &block->elems[index]; }
+
+        basic_iterator &operator++() {
+            if (++index == block->count) {
+                block = block->next;
+                index = 0;
+            }
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const basic_iterator &a,
+                               const basic_iterator &b) {
+            return a.block == b.block && a.index == b.index;
+        }
+        friend bool operator!=(const basic_iterator &a,
+                               const basic_iterator &b) {
+            return !(a == b);
+        }
+
+    private:
+        friend class UnrolledList;
+        template <bool>
+        friend class basic_iterator;
+
+        basic_iterator(Block *block, size_t index)
+            : block(block), index(index) {}
+
+        // Points to an element, or is {nullptr, 0} at the end
+        Block *block = nullptr;
+        size_t index = 0;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    UnrolledList() = default;
+    ~UnrolledList() { clear(); }
+    UnrolledList(const UnrolledList &) = delete;
+    UnrolledList &operator=(const UnrolledList &) = delete;
+
+    iterator begin() { return iterator(head, 0); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return const_iterator(head, 0); }
+    const_iterator end() const { return const_iterator(); }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t blockCount() const { return blocks; }
+
+    void push_back(const T &value) {
+        // Appends fill the last block completely instead of splitting it
+        if (tail == nullptr || tail->count == K) linkAfter(tail, new Block);
+        tail->elems[tail->count++] = value;
+        ++count;
+    }
+
+    void push_front(const T &value) { insert(begin(), value); }
+
+    /// Inserts 'value' before 'pos' and returns an iterator to it
+    iterator insert(const_iterator pos, const T &value) {
+        if (pos.block == nullptr) {
+            push_back(value);
+            return iterator(tail, tail->count - 1);
+        }
+        Block *b = pos.block;
+        size_t i = pos.index;
+        if (b->count == K) {
+            // Split: the upper half goes to a new block after b
+            Block *upper = new Block;
+            linkAfter(b, upper);
+            moveElements(b, K / 2, K, upper, 0);
+            upper->count = K - K / 2;
+            b->count = K / 2;
+            if (i > b->count) {
+                i -= b->count;
+                b = upper;
+            }
+        }
+        for (size_t j = b->count; j > i; --j)
+            b->elems[j] = std::move(b->elems[j - 1]);
+        b->elems[i] = value;
+        ++b->count;
+        ++count;
+        return iterator(b, i);
+    }
+
+    /// Erases the element at 'pos' and returns an iterator to the one after
+    iterator erase(const_iterator pos) {
+        Block *b = pos.block;
+        const size_t i = pos.index;
+        for (size_t j = i + 1; j < b->count; ++j)
+            b->elems[j - 1] = std::move(b->elems[j]);
+        --b->count;
+        --count;
+
+        Block *next = b->next;
+        if (b->count < K / 2 && next != nullptr) {
+            if (next->count > K / 2) {
+                // Borrow the first element of the next block
+                b->elems[b->count++] = std::move(next->elems[0]);
+                moveElements(next, 1, next->count, next, 0);
+                --next->count;
+            } else {
+                // Merge the next block into this one
+                moveElements(next, 0, next->count, b, b->count);
+                b->count += next->count;
+                unlink(next);
+            }
+        }
+        if (b->count == 0) {
+            next = b->next;
+            unlink(b);
+            return iterator(next, 0);
+        }
+        if (i < b->count) return iterator(b, i);
+        return iterator(b->next, 0);
+    }
+
+    void clear() {
+        while (head != nullptr) {
+            Block *next = head->next;
+            delete head;
+            head = next;
+        }
+        tail = nullptr;
+        count = blocks = 0;
+    }
+
+    /// Calls f(const T *elems, size_t n) for the elements of every block, in
+    /// order. Loops over 'elems' run over contiguous memory.
+    template <typename F>
+    void forEachBlock(F f) const {
+        for (const Block *b = head; b != nullptr; b = b->next)
+            f(static_cast<const T *>(b->elems), b->count);
+    }
+
+    /// Number of elements equal to 'value'
+    size_t countOf(const T &value) const {
+        size_t n = 0;
+        for (const Block *b = head; b != nullptr; b = b->next)
+            n += countInBlock(b, value);
+        return n;
+    }
+
+    /// The first element equal to 'value', or end()
+    const_iterator find(const T &value) const {
+        for (const Block *b = head; b != nullptr; b = b->next) {
+            // A branch-free scan finds the block, only then the element
+            if (countInBlock(b, value) == 0) continue;
+            size_t i = 0;
+            while (!(b->elems[i] == value)) ++i;
+            return const_iterator(const_cast<Block *>(b), i);
+        }
+        return end();
+    }
+
+private:
+    static size_t countInBlock(const Block *b, const T &value) {
+        size_t n = 0;
+        for (size_t i = 0; i < b->count; ++i) n += b->elems[i] == value;
+        return n;
+    }
+
+    // Moves from[first, last) to to[dest, ...); the ranges may overlap if
+    // dest <= first
+    static void moveElements(Block *from, size_t first, size_t last, Block *to,
+                             size_t dest) {
+        for (size_t i = first; i < last; ++i)
+            to->elems[dest++] = std::move(from->elems[i]);
+    }
+
+    // Links 'b' in after 'pos' (at the front if 'pos' is nullptr)
+    void linkAfter(Block *pos, Block *b) {
+        b->prev = pos;
+        b->next = pos != nullptr ? pos->next : head;
+        if (b->next != nullptr)
+            b->next->prev = b;
+        else
+            tail = b;
+        if (pos != nullptr)
+            pos->next = b;
+        else
+            head = b;
+        ++blocks;
+    }
+
+    void unlink(Block *b) {
+        if (b->prev != nullptr)
+            b->prev->next = b->next;
+        else
+            head = b->next;
+        if (b->next != nullptr)
+            b->next->prev = b->prev;
+        else
+            tail = b->prev;
+        delete b;
+        --blocks;
+    }
+
+    Block *head = nullptr;
+    Block *tail = nullptr;
+    size_t count = 0;
+    size_t blocks = 0;
+};
+
+#endif  // UNROLLED_LIST_H_
@@ -0,0 +1,346 @@
+// Benchmark of the overhead of sint compared to plain int.
+//
+// Runs four typical kernels over arrays of int, sint (throws) and the
+// non-throwing sint policies and reports for every combination:
+//   - the time per element in nanoseconds (best of several runs) and the
+//     throughput in million elements per second
+//   - the slowdown compared to the same kernel on int
+//   - whether the compiler vectorized the kernel. GCC writes its optimization
+//     notes to bench_sint.vec (see the Makefile); every kernel is compiled
+//     into a function of its own, so its notes can be found by the line of
+//     that function. Without the file (e.g. when built with clang) the column
+//     shows 'n/a'.
+//   - whether the results agree with the ones on int
+//
+// The inputs are small enough that no kernel overflows, so every variant
+// computes the same results and only the cost of the checks is measured.
+//
+// A human readable table goes to stdout, the same data as CSV goes to the file
+// given with '--csv' (default: bench_sint.csv).
+//
+// Usage: ./bench_sint [--sizes 1000,100000] [--csv FILE] [--vec-report FILE]
+
+#include <algorithm>  // std::min, std::fill
+#include <chrono>     // Timing capabilities
+#include <cstdlib>    // std::strtoul, std::atoi
+#include <cstring>    // std::strcmp
+#include <fstream>    // std::ofstream, std::ifstream
+#include <iomanip>    // std::setw
+#include <iostream>
+#include <map>
+#include <random>  // std::mt19937
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "sint.h"
+
+struct options {
+    // The dot product of the inputs stays below 15 * 7 * n, so n must not
+    // exceed 2 * 10^7
+    std::vector<size_t> sizes = {1000, 100000, 10000000};
+    std::string csv = "bench_sint.csv";
+    std::string vec_report = "bench_sint.vec";
+};
+
+struct result_row {
+    std::string kernel;
+    std::string type;
+    size_t n;
+    double ns_per_element;
+    double slowdown;  // compared to int
+    std::string vectorized;
+    bool ok;
+};
+
+// --- Element types. Arithmetic on T gives acc_t<T>: T itself, or a
+// sint_expected for the return_error policy.
+
+template <typename T>
+using acc_t = decltype(T() + T());
+
+long long raw(int x) { return x; }
+
+template <typename Int, typename Policy>
+long long raw(basic_sint<Int, Policy> x) {
+    return x.getUnderlyingValue();
+}
+
+template <typename S>
+long long raw(const sint_expected<S> &x) {
+    return raw(x.value());
+}
+
+template <typename T>
+struct buffers {
+    std::vector<T> a, b;         // operands
+    std::vector<acc_t<T>> out;   // prefix sums, polynomial values
+    std::vector<acc_t<T>> bins;  // histogram
+};
+
+// The inputs of every type, filled by setup()
+template <typename T>
+buffers<T> &data() {
+    static buffers<T> buf;
+    return buf;
+}
+
+template <typename T>
+void setup(size_t n) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> a(-15, 15), b(-7, 7);
+    buffers<T> &buf = data<T>();
+    buf.a.resize(n);
+    buf.b.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        buf.a[i] = a(gen);
+        buf.b[i] = b(gen);
+    }
+    buf.out.assign(n, 0);
+    buf.bins.assign(256, 0);
+}
+
+// Sum of the results, to compare them with the ones on int
+template <typename T>
+long long checksum(const buffers<T> &buf) {
+    long long sum = 0;
+    for (const auto &x : buf.out) sum += raw(x);
+    for (size_t i = 0; i < buf.bins.size(); ++i)
+        sum += raw(buf.bins[i]) * static_cast<long long>(i);
+    return sum;
+}
+
+template <typename T>
+long long check_results() {
+    return checksum(data<T>());
+}
+
+// Not part of the kernels' own functions, so its loop does not show up in
+// their vectorization reports
+template <typename V>
+__attribute__((noinline)) void clear(V &v) {
+    std::fill(v.begin(), v.end(), 0);
+}
+
+// --- The kernels. Each returns a value that depends on all of its work.
+
+template <typename T>
+long long prefix_sum(buffers<T> &buf) {
+    const size_t n = buf.a.size();
+    acc_t<T> acc = 0;
+    for (size_t i = 0; i < n; ++i) buf.out[i] = acc = acc + buf.a[i];
+    return raw(acc);
+}
+
+template <typename T>
+long long dot_product(buffers<T> &buf) {
+    const size_t n = buf.a.size();
+    acc_t<T> acc = 0;
+    for (size_t i = 0; i < n; ++i) acc = acc + buf.a[i] * buf.b[i];
+    return raw(acc);
+}
+
+// 3x^4 - 5x^3 + 2x^2 + 7x - 1 at every a[i] (Horner's method)
+template <typename T>
+long long polynomial(buffers<T> &buf) {
+    const size_t n = buf.a.size();
+    const T c4 = 3, c3 = -5, c2 = 2, c1 = 7, c0 = -1;
+    for (size_t i = 0; i < n; ++i) {
+        const T x = buf.a[i];
+        buf.out[i] = (((c4 * x + c3) * x + c2) * x + c1) * x + c0;
+    }
+    return raw(buf.out[n - 1]);
+}
+
+template <typename T>
+long long histogram(buffers<T> &buf) {
+    const size_t n = buf.a.size();
+    clear(buf.bins);
+    for (size_t i = 0; i < n; ++i) {
+        acc_t<T> &bin = buf.bins[raw(buf.a[i]) & 255];
+        bin = bin + 1;
+    }
+    return raw(buf.bins[0]);
+}
+
+// --- Registry of all combinations of kernel and type
+
+struct benchmark {
+    std::string kernel;
+    std::string type;
+    int line;  // of the function, to find it in the vectorization report
+    long long (*run)();
+    long long (*check)();  // checksum of the results of the last run
+    void (*setup)(size_t);
+};
+
+std::vector<benchmark> &registry() {
+    static std::vector<benchmark> list;
+    return list;
+}
+
+struct registrar {
+    registrar(const benchmark &b) { registry().push_back(b); }
+};
+
+// Defines the function 'kernel_T' with everything the kernel calls inlined
+// into it (flatten) and the function itself never inlined, so the compiler
+// reports on it separately. Each use has to be on a line of its own.
+#define BENCH_KERNEL(kernel, T)                                         \
+    __attribute__((noinline, flatten)) long long kernel##_##T() {       \
+        return kernel(data<T>());                                       \
+    }                                                                   \
+    const registrar kernel##_##T##_registrar(                           \
+        {#kernel, #T, __LINE__, kernel##_##T, check_results<T>, setup<T>});
+
+BENCH_KERNEL(prefix_sum, int)
+BENCH_KERNEL(prefix_sum, sint)
+BENCH_KERNEL(prefix_sum, saturating_sint)
+BENCH_KERNEL(prefix_sum, wrapping_sint)
+BENCH_KERNEL(prefix_sum, checked_sint)
+BENCH_KERNEL(dot_product, int)
+BENCH_KERNEL(dot_product, sint)
+BENCH_KERNEL(dot_product, saturating_sint)
+BENCH_KERNEL(dot_product, wrapping_sint)
+BENCH_KERNEL(dot_product, checked_sint)
+BENCH_KERNEL(polynomial, int)
+BENCH_KERNEL(polynomial, sint)
+BENCH_KERNEL(polynomial, saturating_sint)
+BENCH_KERNEL(polynomial, wrapping_sint)
+BENCH_KERNEL(polynomial, checked_sint)
+BENCH_KERNEL(histogram, int)
+BENCH_KERNEL(histogram, sint)
+BENCH_KERNEL(histogram, saturating_sint)
+BENCH_KERNEL(histogram, wrapping_sint)
+BENCH_KERNEL(histogram, checked_sint)
+
+// Reads the lines "bench_sint.cpp:LINE:COL: note: vectorized N loops in
+// function." of a GCC report into a map from LINE to N
+std::map<int, int> read_vec_report(const std::string &path, bool &found) {
+    std::map<int, int> loops;
+    std::ifstream in(path);
+    found = static_cast<bool>(in);
+    const std::string file = "bench_sint.cpp:";
+    const std::string note = "note: vectorized ";
+    for (std::string line; std::getline(in, line);) {
+        const size_t pos = line.find(note);
+        if (line.compare(0, file.size(), file) != 0 ||
+            pos == std::string::npos ||
+            line.find("loops in function") == std::string::npos)
+            continue;
+        const int at = std::atoi(line.c_str() + file.size());
+        loops[at] += std::atoi(line.c_str() + pos + note.size());
+    }
+    return loops;
+}
+
+// Runs 'b' until at least 'min_time' seconds have passed and returns the
+// fastest run in nanoseconds per element. Small inputs are run in batches, so
+// the resolution of the clock does not matter.
+double best_time(const benchmark &b, size_t n, long long &value,
+                 double min_time = 0.2, int min_runs = 3) {
+    const size_t batch = std::max<size_t>(1, 100000 / n);
+    double best = 1e300, total = 0;
+    for (int run = 0; run < min_runs || total < min_time; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < batch; ++i) value = b.run();
+        auto end = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double>(end - start).count();
+        best = std::min(best, t);
+        total += t;
+    }
+    return best / (batch * n) * 1e9;
+}
+
+void bench(const options &opt, std::vector<result_row> &rows) {
+    bool have_report;
+    const std::map<int, int> loops = read_vec_report(opt.vec_report,
+                                                     have_report);
+    for (size_t n : opt.sizes) {
+        if (n == 0) continue;
+        for (const benchmark &b : registry()) b.setup(n);
+
+        // Results and time of int, per kernel
+        std::map<std::string, long long> expected_value, expected_sum;
+        std::map<std::string, double> int_time;
+        for (const benchmark &b : registry()) {
+            result_row row = {b.kernel, b.type, n, 0, 1, "n/a", true};
+            long long value = 0;
+            wrap_on_error::clear();
+            row.ns_per_element = best_time(b, n, value);
+            const long long sum = b.check();
+            if (b.type == "int") {
+                expected_value[b.kernel] = value;
+                expected_sum[b.kernel] = sum;
+                int_time[b.kernel] = row.ns_per_element;
+            }
+            row.ok = value == expected_value[b.kernel] &&
+                     sum == expected_sum[b.kernel] && !wrap_on_error::failed();
+            row.slowdown = row.ns_per_element / int_time[b.kernel];
+            if (have_report) {
+                auto it = loops.find(b.line);
+                row.vectorized = it != loops.end() && it->second > 0 ? "yes"
+                                                                     : "no";
+            }
+            rows.push_back(row);
+        }
+    }
+}
+
+std::vector<size_t> parse_sizes(const std::string &list) {
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');)
+        sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+    return sizes;
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc)
+            opt.sizes = parse_sizes(argv[++i]);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+            opt.csv = argv[++i];
+        else if (!std::strcmp(argv[i], "--vec-report") && i + 1 < argc)
+            opt.vec_report = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--sizes 1000,100000] [--csv FILE]"
+                         " [--vec-report FILE]\n";
+            return 1;
+        }
+    }
+
+    std::ofstream csv(opt.csv);
+    if (!csv) {
+        std::cerr << "Could not open the file " << opt.csv << '\n';
+        return 1;
+    }
+
+    std::vector<result_row> rows;
+    bench(opt, rows);
+
+    csv << "kernel,type,n,ns_per_element,melements_per_second,slowdown,"
+           "vectorized,ok\n";
+    std::cout << std::left << std::setw(13) << "kernel" << std::setw(17)
+              << "type" << std::right << std::setw(10) << "n" << std::setw(10)
+              << "ns/elem" << std::setw(10) << "Melem/s" << std::setw(10)
+              << "vs int" << std::setw(12) << "vectorized" << "  check\n";
+    for (const auto &r : rows) {
+        const double throughput = 1e3 / r.ns_per_element;
+        csv << r.kernel << ',' << r.type << ',' << r.n << ','
+            << r.ns_per_element << ',' << throughput << ',' << r.slowdown
+            << ',' << r.vectorized << ',' << (r.ok ? "ok" : "FAIL") << '\n';
+
+        std::cout << std::left << std::setw(13) << r.kernel << std::setw(17)
+                  << r.type << std::right << std::setw(10) << r.n << std::fixed
+                  << std::setprecision(2) << std::setw(10) << r.ns_per_element
+                  << std::setw(10) << std::setprecision(0) << throughput
+                  << std::setw(9) << std::setprecision(2) << r.slowdown << 'x'
+                  << std::setw(12) << r.vectorized << "  "
+                  << (r.ok ? "ok" : "FAIL") << '\n';
+    }
+
+    return 0;
+}
@@ -15,6 +15,7 @@
 #include <limits>
 
 #include "sint.h"
+#include "sint_array.h"
 
 int main() {
     // You are of course free to extend these tests!
@@ -33,6 +34,28 @@ int main() {
     std::cout << "++c: " << c << '\n';
     --c;
     std::cout << "--c: " << c << '\n';
+    std::cout << "c++ returns the old value: " << c++ << '\n';
+    c--;
+
+    // the other policies never throw
+    saturating_sint s = std::numeric_limits<int>::max();
+    std::cout << "saturated: " << s + saturating_sint(10) << '\n';
+    wrapping_sint w = std::numeric_limits<int>::max();
+    w = w + wrapping_sint(1);
+    std::cout << "wrapped: " << w << ", failed: " << wrap_on_error::failed()
+              << '\n';
+    checked_sint x = std::numeric_limits<int>::max();
+    sint_expected<checked_sint> r = x * checked_sint(2) + checked_sint(1);
+    std::cout << "checked: " << r << ", has value: " << r.has_value() << '\n';
+    sint8 small = 100;
+    std::cout << "8 bit: " << (small - sint8(-27)) << '\n';
+
+    // arrays: one overflow check per batch instead of one per element
+    sint prices[] = {100, 250, std::numeric_limits<int>::max(), 5};
+    sint fees[] = {1, 2, 3, 4};
+    sint totals[4];
+    array_status status = add(prices, fees, totals, 4);
+    std::cout << "first overflow at index: " << status.first_overflow << '\n';
 
     // setup some values
     sint max = std::numeric_limits<int>::max();
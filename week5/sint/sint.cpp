@@ -12,95 +12,39 @@
 
 #include "sint.h"
 
-// -- Constructors / Destructors
-
-sint::sint() : value(0) {}
-sint::sint(int i) : value(i) {}
-sint::~sint() = default;
-
-// -- Copy/Move ctors and assinment operators
-
-sint::sint(const sint &s) = default;
-
-sint &sint::operator=(const sint &s) = default;
-
-sint::sint(sint &&s) = default;
-
-sint &sint::operator=(sint &&s) = default;
-
-// -- Methods
-
-int sint::getUnderlyingValue() const noexcept { return value; }
-
-// -- Operators
-
-sint operator+(sint lhs, sint rhs) {
-    sint result;
-    if (__builtin_add_overflow(lhs.value, rhs.value, &result.value))
-        // In the case of addition only overflow would make sense
-        throw std::overflow_error("ERROR: Integer overflow; result: " +
-                                  std::to_string(result.value));
-    return result;
-}
-
-sint operator-(sint lhs, sint rhs) {
-    sint result;
-    if (__builtin_sub_overflow(lhs.value, rhs.value, &result.value))
-        // In the case of addition only underflow would make sense
-        throw std::underflow_error("ERROR: Integer underflow; result: " +
-                                   std::to_string(result.value));
-    return result;
+#include <stdexcept>
+
+// The operators are templates in sint.h. Only the construction and throwing
+// of the exceptions lives here: it is the cold path, and keeping it out of
+// line keeps the inlined operators small.
+
+namespace sint_detail {
+
+__attribute__((noinline, cold)) void throw_error(sint_error error,
+                                                 long long result) {
+    switch (error) {
+        case sint_error::overflow:
+            throw std::overflow_error("ERROR: Integer overflow; result: " +
+                                      std::to_string(result));
+        case sint_error::underflow:
+            throw std::underflow_error("ERROR: Integer underflow; result: " +
+                                       std::to_string(result));
+        case sint_error::division_by_zero:
+            // For the case of division by zero throw an logical error
+            throw std::logic_error("ERROR: Division by zero");
+        case sint_error::none:
+            break;
+    }
+    throw std::logic_error("ERROR: Unknown sint error");
 }
 
-sint operator*(sint lhs, sint rhs) {
-    sint result;
-    if (__builtin_mul_overflow(lhs.value, rhs.value, &result.value))
-        // In the case of addition only overflow would make sense
-        throw std::overflow_error("ERROR: Integer overflow; result: " +
-                                  std::to_string(result.value));
-    return result;
+__attribute__((noinline, cold)) void throw_bad_access(sint_error error) {
+    throw std::logic_error(
+        "ERROR: Access to the value of a failed sint operation (error " +
+        std::to_string(static_cast<int>(error)) + ")");
 }
 
-sint operator/(sint lhs, sint rhs) {
-    sint result;
-    if (rhs.value == 0)
-        // For the case of division by zero throw an logical error
-        throw std::logic_error("ERROR: Division by zero");
-    return lhs.value / rhs.value;
-}
-
-sint &sint::operator++() {
-    if (__builtin_add_overflow(value, 1, &value))
-        throw std::overflow_error("ERROR: Integer overflow; result: " +
-                                  std::to_string(value));
-    return *this;
-}
-
-sint sint::operator++(int) {
-    if (__builtin_add_overflow(value, 1, &value))
-        throw std::overflow_error("ERROR: Integer overflow; result: " +
-                                  std::to_string(value));
-    return *this;
-}
-
-sint &sint::operator--() {
-    if (__builtin_sub_overflow(value, 1, &value))
-        throw std::underflow_error("ERROR: Integer underflow; result: " +
-                                   std::to_string(value));
-
-    return *this;
-}
-
-sint sint::operator--(int) {
-    if (__builtin_sub_overflow(value, 1, &value))
-        throw std::underflow_error("ERROR: Integer underflow; result: " +
-                                   std::to_string(value));
-    return *this;
-}
-
-std::ostream &operator<<(std::ostream &os, const sint &s) {
-    return os << s.value;
-}
+}  // namespace sint_detail
 
 // Refs:
 // ---------------------------
@@ -13,33 +13,297 @@
 #ifndef SINT_H_
 #define SINT_H_
 
+#include <cstdint>
 #include <exception>
 #include <iostream>
 #include <limits>
 #include <string>
+#include <type_traits>
+
+// --- Safe integers
+//
+// basic_sint<Int, Policy> wraps a signed integer of any width and checks
+// every operation for overflow, underflow and division by zero. What happens
+// then is decided at compile time by the policy:
+//
+//   throw_on_error     throw std::overflow_error / std::underflow_error /
+//                      std::logic_error (the classic sint)
+//   saturate_on_error  clamp the result to the smallest/largest value
+//   wrap_on_error      wrap around (two's complement) and set a sticky flag
+//                      that can be checked once after a whole computation
+//   return_error       return a sint_expected, which holds either the result
+//                      or the error, and propagates errors through further
+//                      arithmetic
+//
+// Everything but the construction of the exceptions is inline, so the
+// checks cost a compare and an (almost never taken) branch.
+
+/// What went wrong in an operation
+enum class sint_error { none, overflow, underflow, division_by_zero };
+
+namespace sint_detail {
+
+// Cold paths, defined in sint.cpp
+[[noreturn]] void throw_error(sint_error error, long long result);
+[[noreturn]] void throw_bad_access(sint_error error);
+
+}  // namespace sint_detail
+
+template <typename S>
+class sint_expected;
+
+// --- Policies. fail() is called with the kind of error, the wrapped (two's
+// complement) result and the saturated one and returns the result of the
+// operation.
+
+struct throw_on_error {
+    template <typename S>
+    using result = S;
+
+    template <typename S>
+    static S fail(sint_error error, typename S::value_type wrapped,
+                  typename S::value_type) {
+        sint_detail::throw_error(error, static_cast<long long>(wrapped));
+    }
+};
+
+struct saturate_on_error {
+    template <typename S>
+    using result = S;
+
+    template <typename S>
+    static S fail(sint_error, typename S::value_type,
+                  typename S::value_type saturated) {
+        return S(saturated);
+    }
+};
+
+struct wrap_on_error {
+    template <typename S>
+    using result = S;
+
+    template <typename S>
+    static S fail(sint_error, typename S::value_type wrapped,
+                  typename S::value_type) {
+        flag() = true;
+        return S(wrapped);
+    }
+
+    /// Whether an operation of this thread failed since the last clear()
+    static bool failed() { return flag(); }
+    static void clear() { flag() = false; }
 
-class sint {
 private:
-    int value;
+    static bool &flag() {
+        thread_local bool failed = false;
+        return failed;
+    }
+};
+
+struct return_error {
+    template <typename S>
+    using result = sint_expected<S>;
+
+    template <typename S>
+    static sint_expected<S> fail(sint_error error, typename S::value_type,
+                                 typename S::value_type) {
+        return error;
+    }
+};
+
+template <typename Int, typename Policy = throw_on_error>
+class basic_sint {
+    static_assert(std::is_integral<Int>::value && std::is_signed<Int>::value,
+                  "basic_sint needs a signed integer type");
 
 public:
-    sint();
-    sint(int i);
-    ~sint();
-    sint(const sint &s);
-    sint &operator=(const sint &s);
-    sint(sint &&s);
-    sint &operator=(sint &&s);
-    int getUnderlyingValue() const noexcept;
-    friend sint operator+(sint lhs, sint rhs);
-    friend sint operator-(sint lhs, sint rhs);
-    friend sint operator*(sint lhs, sint rhs);
-    friend sint operator/(sint lhs, sint rhs);
-    sint &operator++();    // prefix ++: no parameter, returns a reference
-    sint operator++(int);  // postfix ++: dummy parameter, returns a value
-    sint &operator--();    // prefix ++: no parameter, returns a reference
-    sint operator--(int);  // postfix ++: dummy parameter, returns a value
-    friend std::ostream &operator<<(std::ostream &os, const sint &s);
+    using value_type = Int;
+    using policy = Policy;
+    /// Type of the results of the arithmetic operators
+    using result = typename Policy::template result<basic_sint>;
+
+    basic_sint() : value(0) {}
+    basic_sint(Int i) : value(i) {}
+
+    Int getUnderlyingValue() const noexcept { return value; }
+
+    friend result operator+(basic_sint lhs, basic_sint rhs) {
+        Int r;
+        if (__builtin_expect(__builtin_add_overflow(lhs.value, rhs.value, &r),
+                             0))
+            // Reported as overflow, like the original sint did
+            return Policy::template fail<basic_sint>(
+                sint_error::overflow, r, lhs.value > 0 ? max() : min());
+        return basic_sint(r);
+    }
+
+    friend result operator-(basic_sint lhs, basic_sint rhs) {
+        Int r;
+        if (__builtin_expect(__builtin_sub_overflow(lhs.value, rhs.value, &r),
+                             0))
+            return Policy::template fail<basic_sint>(
+                sint_error::underflow, r, lhs.value >= 0 ? max() : min());
+        return basic_sint(r);
+    }
+
+    friend result operator*(basic_sint lhs, basic_sint rhs) {
+        Int r;
+        if (__builtin_expect(__builtin_mul_overflow(lhs.value, rhs.value, &r),
+                             0))
+            return Policy::template fail<basic_sint>(
+                sint_error::overflow, r,
+                (lhs.value < 0) != (rhs.value < 0) ? min() : max());
+        return basic_sint(r);
+    }
+
+    friend result operator/(basic_sint lhs, basic_sint rhs) {
+        if (__builtin_expect(rhs.value == 0, 0))
+            return Policy::template fail<basic_sint>(
+                sint_error::division_by_zero, 0,
+                lhs.value > 0 ? max() : lhs.value < 0 ? min() : 0);
+        // The only quotient that does not fit: min / -1 = max + 1
+        if (__builtin_expect(lhs.value == min() && rhs.value == -1, 0))
+            return Policy::template fail<basic_sint>(sint_error::overflow,
+                                                     min(), max());
+        return basic_sint(static_cast<Int>(lhs.value / rhs.value));
+    }
+
+    // The increment and decrement operators change the sint in place, so
+    // they are only there for policies whose result is a sint again (use
+    // 'x = x + 1' with return_error).
+
+    basic_sint &operator++() {  // prefix ++: returns a reference
+        *this = increment();
+        return *this;
+    }
+
+    basic_sint operator++(int) {  // postfix ++: returns the old value
+        basic_sint old = *this;
+        *this = increment();
+        return old;
+    }
+
+    basic_sint &operator--() {  // prefix --: returns a reference
+        *this = decrement();
+        return *this;
+    }
+
+    basic_sint operator--(int) {  // postfix --: returns the old value
+        basic_sint old = *this;
+        *this = decrement();
+        return old;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const basic_sint &s) {
+        // '+' prints 8-bit integers as numbers, not as characters
+        return os << +s.value;
+    }
+
+private:
+    static constexpr Int min() { return std::numeric_limits<Int>::min(); }
+    static constexpr Int max() { return std::numeric_limits<Int>::max(); }
+
+    basic_sint increment() const {
+        static_assert(std::is_same<result, basic_sint>::value,
+                      "++ needs a policy that returns a sint");
+        Int r;
+        if (__builtin_expect(__builtin_add_overflow(value, Int(1), &r), 0))
+            return Policy::template fail<basic_sint>(sint_error::overflow, r,
+                                                     max());
+        return basic_sint(r);
+    }
+
+    basic_sint decrement() const {
+        static_assert(std::is_same<result, basic_sint>::value,
+                      "-- needs a policy that returns a sint");
+        Int r;
+        if (__builtin_expect(__builtin_sub_overflow(value, Int(1), &r), 0))
+            return Policy::template fail<basic_sint>(sint_error::underflow, r,
+                                                     min());
+        return basic_sint(r);
+    }
+
+    Int value;
+};
+
+/// Result of an operation with the return_error policy: either a sint or the
+/// error that happened on the way. Arithmetic with a sint_expected that
+/// holds an error gives that error again, so a whole expression can be
+/// checked once at the end:
+///
+///     checked_sint a = ..., b = ..., c = ...;
+///     sint_expected<checked_sint> r = a * b + c;
+///     if (!r) handle(r.error());
+template <typename S>
+class sint_expected {
+public:
+    sint_expected(S value) : val(value), err(sint_error::none) {}
+    sint_expected(typename S::value_type value)
+        : val(value), err(sint_error::none) {}
+    sint_expected(sint_error error) : err(error) {}
+
+    bool has_value() const { return err == sint_error::none; }
+    explicit operator bool() const { return has_value(); }
+    sint_error error() const { return err; }
+
+    /// The result. Throws std::logic_error if there is none.
+    S value() const {
+        if (!has_value()) sint_detail::throw_bad_access(err);
+        return val;
+    }
+
+    S value_or(S fallback) const { return has_value() ? val : fallback; }
+
+    friend sint_expected operator+(const sint_expected &lhs,
+                                   const sint_expected &rhs) {
+        if (!lhs) return lhs;
+        if (!rhs) return rhs;
+        return lhs.val + rhs.val;
+    }
+
+    friend sint_expected operator-(const sint_expected &lhs,
+                                   const sint_expected &rhs) {
+        if (!lhs) return lhs;
+        if (!rhs) return rhs;
+        return lhs.val - rhs.val;
+    }
+
+    friend sint_expected operator*(const sint_expected &lhs,
+                                   const sint_expected &rhs) {
+        if (!lhs) return lhs;
+        if (!rhs) return rhs;
+        return lhs.val * rhs.val;
+    }
+
+    friend sint_expected operator/(const sint_expected &lhs,
+                                   const sint_expected &rhs) {
+        if (!lhs) return lhs;
+        if (!rhs) return rhs;
+        return lhs.val / rhs.val;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os,
+                                    const sint_expected &e) {
+        if (e) return os << e.val;
+        return os << "<error " << static_cast<int>(e.err) << '>';
+    }
+
+private:
+    S val;
+    sint_error err;
 };
 
+/// The classic sint: int, throws on errors
+using sint = basic_sint<int>;
+
+using sint8 = basic_sint<int8_t>;
+using sint16 = basic_sint<int16_t>;
+using sint32 = basic_sint<int32_t>;
+using sint64 = basic_sint<int64_t>;
+
+/// int with the other policies
+using saturating_sint = basic_sint<int, saturate_on_error>;
+using wrapping_sint = basic_sint<int, wrap_on_error>;
+using checked_sint = basic_sint<int, return_error>;
+
 #endif
@@ -0,0 +1,153 @@
+#include "sint_array.h"
+
+#include <algorithm>  // std::min
+#include <cstdint>
+#include <cstring>  // std::memcpy
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// The kernels read and write the ints inside of the sints directly. A sint
+// is a standard layout class whose only member is an int, so an array of
+// sints has exactly the layout of an array of ints.
+static_assert(sizeof(sint) == sizeof(int), "sint must wrap a single int");
+static_assert(std::is_standard_layout<sint>::value,
+              "sint must have the layout of an int");
+
+// Besides the baseline (SSE2 on x86-64) every kernel is also compiled for
+// AVX2; the dynamic loader picks the version that fits the CPU.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SINT_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define SINT_CLONES
+#endif
+
+namespace {
+
+// The arrays are processed in blocks of this many elements. The results of a
+// block go to a buffer on the stack first, so the inputs of the block are
+// still there for the cold path even if 'out' is the same array as an input.
+const size_t block_size = 1024;
+
+const int *ints(const sint *s) { return reinterpret_cast<const int *>(s); }
+int *ints(sint *s) { return reinterpret_cast<int *>(s); }
+
+// --- Branch-free kernels. They return whether any element overflowed.
+
+// A sum overflows iff both operands have another sign than the result
+SINT_CLONES bool add_kernel(const int *a, const int *b, int *out, size_t n) {
+    int mask = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const int x = a[i], y = b[i];
+        const int r = static_cast<int>(static_cast<unsigned>(x) +
+                                       static_cast<unsigned>(y));
+        mask |= (x ^ r) & (y ^ r);
+        out[i] = r;
+    }
+    return mask < 0;
+}
+
+// A difference overflows iff the operands have different signs and the
+// result has not the sign of the minuend
+SINT_CLONES bool sub_kernel(const int *a, const int *b, int *out, size_t n) {
+    int mask = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const int x = a[i], y = b[i];
+        const int r = static_cast<int>(static_cast<unsigned>(x) -
+                                       static_cast<unsigned>(y));
+        mask |= (x ^ y) & (x ^ r);
+        out[i] = r;
+    }
+    return mask < 0;
+}
+
+// A product overflows iff the exact 64-bit product differs from the
+// sign-extended 32-bit result
+SINT_CLONES bool mul_kernel(const int *a, const int *b, int *out, size_t n) {
+    int64_t mask = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const int64_t p = static_cast<int64_t>(a[i]) * b[i];
+        const int r = static_cast<int>(p);
+        mask |= p ^ r;
+        out[i] = r;
+    }
+    return mask != 0;
+}
+
+// Cannot overflow: n * 2^31 < 2^63 for any array that fits into memory
+SINT_CLONES int64_t sum_kernel(const int *a, size_t n) {
+    int64_t total = 0;
+    for (size_t i = 0; i < n; ++i) total += a[i];
+    return total;
+}
+
+bool fits(int64_t x) {
+    return x >= std::numeric_limits<int>::min() &&
+           x <= std::numeric_limits<int>::max();
+}
+
+// Runs 'kernel' over all blocks and, for the first block that overflowed,
+// finds the element with the scalar check 'overflows' (the cold path)
+template <typename Kernel, typename Overflows>
+array_status run_blocks(const sint *a, const sint *b, sint *out, size_t n,
+                        Kernel kernel, Overflows overflows) {
+    const int *x = ints(a), *y = ints(b);
+    array_status status;
+    int block[block_size];
+    for (size_t first = 0; first < n; first += block_size) {
+        const size_t len = std::min(block_size, n - first);
+        if (kernel(x + first, y + first, block, len) && status.ok()) {
+            size_t i = first;
+            while (!overflows(x[i], y[i])) ++i;
+            status.first_overflow = i;
+        }
+        std::memcpy(ints(out) + first, block, len * sizeof(int));
+    }
+    return status;
+}
+
+}  // namespace
+
+void array_status::check() const {
+    if (!ok())
+        throw std::overflow_error(
+            "ERROR: Integer overflow in array operation at index " +
+            std::to_string(first_overflow));
+}
+
+array_status add(const sint *a, const sint *b, sint *out, size_t n) {
+    return run_blocks(a, b, out, n, add_kernel, [](int x, int y) {
+        int r;
+        return __builtin_add_overflow(x, y, &r);
+    });
+}
+
+array_status sub(const sint *a, const sint *b, sint *out, size_t n) {
+    return run_blocks(a, b, out, n, sub_kernel, [](int x, int y) {
+        int r;
+        return __builtin_sub_overflow(x, y, &r);
+    });
+}
+
+array_status mul(const sint *a, const sint *b, sint *out, size_t n) {
+    return run_blocks(a, b, out, n, mul_kernel, [](int x, int y) {
+        int r;
+        return __builtin_mul_overflow(x, y, &r);
+    });
+}
+
+array_status sum(const sint *a, size_t n, sint &total) {
+    const int *x = ints(a);
+    const int64_t exact = sum_kernel(x, n);
+    *ints(&total) = static_cast<int>(static_cast<uint64_t>(exact));
+    array_status status;
+    if (!fits(exact)) {
+        // The running sum has to leave the range somewhere on the way
+        int64_t running = 0;
+        size_t i = 0;
+        while (fits(running += x[i])) ++i;
+        status.first_overflow = i;
+    }
+    return status;
+}
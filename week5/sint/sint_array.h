@@ -0,0 +1,52 @@
+#ifndef SINT_ARRAY_H_
+#define SINT_ARRAY_H_
+
+#include <cstddef>
+
+#include "sint.h"
+
+// --- Checked arithmetic over arrays of sint
+//
+// The scalar operators of sint check every single operation with a branch
+// and throw right away, which keeps the compiler from vectorizing a loop over
+// them. The kernels below work on whole arrays instead: every element is
+// computed with wrap-around arithmetic, its overflow test is a few bit
+// operations that are OR-ed into a sticky mask, and the mask is only looked
+// at once after the loop. The loops have no branches and are vectorized
+// (built with -O3, with an AVX2 clone that is selected at runtime).
+//
+// Only if the mask says that something overflowed, a second (cold) pass
+// finds the first element that did. The caller decides what to do about it,
+// e.g. call check() to get the same exception as from the scalar operators,
+// once per batch instead of once per element.
+
+/// Outcome of a kernel over an array of sints
+struct array_status {
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /// Index of the first element whose result overflowed, npos if none did
+    size_t first_overflow = npos;
+
+    bool ok() const { return first_overflow == npos; }
+
+    /// Throws std::overflow_error if an element overflowed
+    void check() const;
+};
+
+/// out[i] = a[i] + b[i] for i in [0, n). Elements that overflow get the
+/// wrapped (two's complement) result. 'out' may be the same as 'a' or 'b'.
+array_status add(const sint *a, const sint *b, sint *out, size_t n);
+
+/// out[i] = a[i] - b[i], see add()
+array_status sub(const sint *a, const sint *b, sint *out, size_t n);
+
+/// out[i] = a[i] * b[i], see add()
+array_status mul(const sint *a, const sint *b, sint *out, size_t n);
+
+/// Sum of a[0 .. n). The sum is computed exactly (in 64 bits); it is an
+/// overflow if it does not fit into an int. In that case 'total' is the
+/// wrapped sum and first_overflow the first index at which the running sum
+/// left the range of int.
+array_status sum(const sint *a, size_t n, sint &total);
+
+#endif  // SINT_ARRAY_H_
@@ -0,0 +1,202 @@
+// Benchmark of the matrix multiplication kernels.
+//
+// Sweeps matrix sizes, element types and kernels and reports for every
+// combination:
+//   - GFLOP/s (2 * n^3 floating point or integer operations per product)
+//   - the effective memory bandwidth, based on the compulsory traffic of
+//     reading A and B once and writing C once (3 * n^2 * sizeof(T) bytes)
+//   - the speedup against the naive matrix::operator*
+//
+// A human readable table goes to stdout, the same data as CSV goes to the file
+// given with '--csv' (default: bench.csv) so that runs of different commits
+// can be diffed.
+//
+// Usage: ./bench [--sizes 64,128,256] [--threads N] [--csv FILE]
+
+#include <algorithm>  // std::fill, std::max, std::min
+#include <chrono>     // Timing capabilities
+#include <cmath>      // std::abs
+#include <cstdlib>    // std::strtoul
+#include <cstring>    // std::strcmp
+#include <fstream>    // std::ofstream
+#include <iomanip>    // std::setw
+#include <iostream>
+#include <random>  // std::mt19937
+#include <sstream>
+#include <string>
+#include <thread>  // std::thread::hardware_concurrency
+#include <vector>
+
+#include "gemm.h"
+#include "matrix.h"
+
+struct options {
+    std::vector<size_t> sizes = {64, 128, 256, 512};
+    unsigned threads = std::thread::hardware_concurrency();
+    std::string csv = "bench.csv";
+};
+
+struct result_row {
+    std::string kernel;
+    std::string type;
+    size_t n;
+    unsigned threads;
+    double seconds;
+    double gflops;
+    double bandwidth;
+    double speedup;
+    bool ok;
+};
+
+template <typename T>
+const char *type_name();
+template <>
+const char *type_name<float>() { return "float"; }
+template <>
+const char *type_name<double>() { return "double"; }
+template <>
+const char *type_name<int>() { return "int"; }
+
+template <typename T>
+matrix<T> random_matrix(size_t n, std::mt19937 &gen) {
+    matrix<T> m(n, n);
+    std::uniform_int_distribution<int> dist(-8, 8);
+    for (size_t i = 0; i < m.num_elements(); ++i) m.data()[i] = dist(gen);
+    return m;
+}
+
+// Runs 'kernel' (which resets its output matrix to zero and computes into it)
+// until at least 'min_time' seconds have passed and returns the fastest run in
+// seconds.
+template <typename Kernel>
+double best_time(Kernel kernel, double min_time = 0.2, int min_runs = 3) {
+    double best = 1e300, total = 0;
+    for (int run = 0; run < min_runs || total < min_time; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto end = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double>(end - start).count();
+        best = std::min(best, t);
+        total += t;
+    }
+    return best;
+}
+
+// Sets all elements to zero, without allocating
+template <typename T>
+void clear(matrix<T> &m) {
+    std::fill(m.data(), m.data() + m.num_elements(), T(0));
+}
+
+template <typename T>
+bool same(const matrix<T> &x, const matrix<T> &y) {
+    // Small integer inputs make every product exact, except for the
+    // reassociation of floating point sums in the faster kernels.
+    for (size_t i = 0; i < x.num_elements(); ++i)
+        if (std::abs(double(x.data()[i]) - double(y.data()[i])) >
+            1e-6 * x.num_columns())
+            return false;
+    return true;
+}
+
+template <typename T>
+void bench_type(const options &opt, std::vector<result_row> &rows) {
+    std::mt19937 gen(42);
+    for (size_t n : opt.sizes) {
+        matrix<T> a = random_matrix<T>(n, gen);
+        matrix<T> b = random_matrix<T>(n, gen);
+        matrix<T> reference = a * b;
+
+        const double flop = 2.0 * n * n * n;
+        const double bytes = 3.0 * n * n * sizeof(T);
+        double naive_time = 0;
+
+        auto record = [&](const std::string &kernel, unsigned threads,
+                          double t, const matrix<T> &c) {
+            if (kernel == "naive") naive_time = t;
+            rows.push_back({kernel, type_name<T>(), n, threads, t,
+                            flop / t * 1e-9, bytes / t * 1e-9, naive_time / t,
+                            same(c, reference)});
+        };
+
+        // The naive kernel is operator*, which returns a new matrix. The
+        // others write into 'c', allocated once outside of the timed runs.
+        matrix<T> c(n, n);
+        record("naive", 1, best_time([&] { c = a * b; }), c);
+
+        c = matrix<T>(n, n);
+        record("blocked", 1, best_time([&] {
+                   clear(c);
+                   gemm_blocked(a, b, c);
+               }),
+               c);
+
+        record("simd", 1, best_time([&] {
+                   clear(c);
+                   gemm_simd(a, b, c);
+               }),
+               c);
+
+        record("threaded", opt.threads, best_time([&] {
+                   clear(c);
+                   gemm_threaded(a, b, c, opt.threads);
+               }),
+               c);
+    }
+}
+
+std::vector<size_t> parse_sizes(const std::string &list) {
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');)
+        sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+    return sizes;
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc)
+            opt.sizes = parse_sizes(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+            opt.threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+            opt.csv = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--sizes 64,128,256] [--threads N] [--csv FILE]\n";
+            return 1;
+        }
+    }
+    if (opt.threads == 0) opt.threads = 1;
+
+    std::vector<result_row> rows;
+    bench_type<float>(opt, rows);
+    bench_type<double>(opt, rows);
+    bench_type<int>(opt, rows);
+
+    std::ofstream csv(opt.csv);
+    if (!csv) {
+        std::cerr << "Could not open the file " << opt.csv << '\n';
+        return 1;
+    }
+    csv << "kernel,type,n,threads,seconds,gflops,bandwidth_gbs,speedup,ok\n";
+
+    std::cout << std::left << std::setw(10) << "kernel" << std::setw(8)
+              << "type" << std::right << std::setw(6) << "n" << std::setw(9)
+              << "threads" << std::setw(12) << "GFLOP/s" << std::setw(10)
+              << "GB/s" << std::setw(10) << "speedup" << "  check\n";
+    for (const auto &r : rows) {
+        csv << r.kernel << ',' << r.type << ',' << r.n << ',' << r.threads
+            << ',' << r.seconds << ',' << r.gflops << ',' << r.bandwidth << ','
+            << r.speedup << ',' << (r.ok ? "ok" : "FAIL") << '\n';
+        std::cout << std::left << std::setw(10) << r.kernel << std::setw(8)
+                  << r.type << std::right << std::setw(6) << r.n
+                  << std::setw(9) << r.threads << std::fixed
+                  << std::setprecision(3) << std::setw(12) << r.gflops
+                  << std::setw(10) << r.bandwidth << std::setw(10)
+                  << r.speedup << "  " << (r.ok ? "ok" : "FAIL") << '\n';
+    }
+
+    return 0;
+}
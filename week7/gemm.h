@@ -0,0 +1,171 @@
+#ifndef GEMM_H_
+#define GEMM_H_
+
+#include <algorithm>  // std::min
+#include <cstring>    // std::memcpy
+#include <stdexcept>  // std::invalid_argument
+#include <thread>     // std::thread
+#include <vector>     // std::vector
+
+#include "matrix.h"
+
+// Faster alternatives to matrix::operator* which all compute
+// 'result = lhs * rhs' into an already allocated 'result' matrix. They work
+// directly on the row-major storage, so there is no bounds check in the inner
+// loops. The naive version is matrix::operator* itself.
+
+namespace gemm_detail {
+
+// Edge length of the square tiles used by the blocked kernels. Three tiles of
+// 64x64 doubles (96 KiB) fit nicely into a typical L2 cache.
+const size_t block = 64;
+
+template <typename T>
+void check_sizes(const matrix<T> &lhs, const matrix<T> &rhs,
+                 const matrix<T> &result) {
+    if (lhs.num_columns() != rhs.num_rows())
+        throw std::invalid_argument(
+            "ERROR: Matrices have invalid sizes for "
+            "multiplications!\n\tThey ought to be "
+            "in the form: A(a, N) * B(N, b).");
+    if (result.num_rows() != lhs.num_rows() ||
+        result.num_columns() != rhs.num_columns())
+        throw std::invalid_argument("ERROR: Difference in matrix size");
+}
+
+// Blocked i-k-j product of the rows [row_first, row_last) of C. The innermost
+// loop walks contiguously through a row of B and C.
+template <typename T>
+void blocked_rows(const T *a, const T *b, T *c, size_t n, size_t p,
+                  size_t row_first, size_t row_last) {
+    for (size_t ii = row_first; ii < row_last; ii += block)
+        for (size_t kk = 0; kk < n; kk += block)
+            for (size_t jj = 0; jj < p; jj += block) {
+                size_t i_end = std::min(ii + block, row_last);
+                size_t k_end = std::min(kk + block, n);
+                size_t j_end = std::min(jj + block, p);
+                for (size_t i = ii; i < i_end; ++i)
+                    for (size_t k = kk; k < k_end; ++k) {
+                        const T aik = a[i * n + k];
+                        for (size_t j = jj; j < j_end; ++j)
+                            c[i * p + j] += aik * b[k * p + j];
+                    }
+            }
+}
+
+// Explicitly vectorized product of the rows [row_first, row_last) of C using
+// the GCC/Clang vector extension, which maps onto whatever SIMD instruction
+// set is enabled (-march=native). A micro kernel keeps a 4 x (2 * width) tile
+// of C in 8 registers while streaming through a k-block of A and B, so every
+// load of B is reused by four rows. Leftover rows/columns use the scalar loop.
+template <typename T>
+void simd_rows(const T *a, const T *b, T *c, size_t n, size_t p,
+               size_t row_first, size_t row_last) {
+    typedef T simd_t __attribute__((vector_size(32)));
+    const size_t width = sizeof(simd_t) / sizeof(T);
+    const size_t tile = 2 * width;
+
+    for (size_t kk = 0; kk < n; kk += block) {
+        size_t k_end = std::min(kk + block, n);
+        size_t i = row_first;
+        for (; i + 4 <= row_last; i += 4) {
+            size_t j = 0;
+            for (; j + tile <= p; j += tile) {
+                simd_t acc[4][2];
+                for (size_t r = 0; r < 4; ++r) {
+                    std::memcpy(&acc[r][0], c + (i + r) * p + j,
+                                sizeof(simd_t));
+                    std::memcpy(&acc[r][1], c + (i + r) * p + j + width,
+                                sizeof(simd_t));
+                }
+                for (size_t k = kk; k < k_end; ++k) {
+                    simd_t b0, b1;
+                    std::memcpy(&b0, b + k * p + j, sizeof(simd_t));
+                    std::memcpy(&b1, b + k * p + j + width, sizeof(simd_t));
+                    for (size_t r = 0; r < 4; ++r) {
+                        // Broadcast a(i + r, k) to all lanes
+                        simd_t air = simd_t{} + a[(i + r) * n + k];
+                        acc[r][0] += air * b0;
+                        acc[r][1] += air * b1;
+                    }
+                }
+                for (size_t r = 0; r < 4; ++r) {
+                    std::memcpy(c + (i + r) * p + j, &acc[r][0],
+                                sizeof(simd_t));
+                    std::memcpy(c + (i + r) * p + j + width, &acc[r][1],
+                                sizeof(simd_t));
+                }
+            }
+            // Remaining columns of these four rows
+            for (size_t r = 0; r < 4; ++r)
+                for (size_t k = kk; k < k_end; ++k)
+                    for (size_t jr = j; jr < p; ++jr)
+                        c[(i + r) * p + jr] +=
+                            a[(i + r) * n + k] * b[k * p + jr];
+        }
+        // Remaining rows
+        for (; i < row_last; ++i)
+            for (size_t k = kk; k < k_end; ++k)
+                for (size_t j = 0; j < p; ++j)
+                    c[i * p + j] += a[i * n + k] * b[k * p + j];
+    }
+}
+
+}  // namespace gemm_detail
+
+/// Cache blocked product (tiles of gemm_detail::block x gemm_detail::block).
+/// 'result' has to be zero initialized.
+template <typename T>
+void gemm_blocked(const matrix<T> &lhs, const matrix<T> &rhs,
+                  matrix<T> &result) {
+    gemm_detail::check_sizes(lhs, rhs, result);
+    gemm_detail::blocked_rows(lhs.data(), rhs.data(), result.data(),
+                              lhs.num_columns(), rhs.num_columns(), 0,
+                              lhs.num_rows());
+}
+
+/// Blocked product with an explicitly vectorized register-tiled micro kernel.
+/// 'result' has to be zero initialized.
+template <typename T>
+void gemm_simd(const matrix<T> &lhs, const matrix<T> &rhs,
+               matrix<T> &result) {
+    gemm_detail::check_sizes(lhs, rhs, result);
+    gemm_detail::simd_rows(lhs.data(), rhs.data(), result.data(),
+                           lhs.num_columns(), rhs.num_columns(), 0,
+                           lhs.num_rows());
+}
+
+/// gemm_simd with the rows of 'result' split into bands, one per thread
+/// (0: one per hardware thread). 'result' has to be zero initialized.
+template <typename T>
+void gemm_threaded(const matrix<T> &lhs, const matrix<T> &rhs,
+                   matrix<T> &result, unsigned threads = 0) {
+    gemm_detail::check_sizes(lhs, rhs, result);
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    const size_t rows = lhs.num_rows();
+    // Bands are a multiple of 4 rows to keep the micro kernel busy
+    size_t band = (rows + threads - 1) / threads;
+    band = (band + 3) / 4 * 4;
+
+    std::vector<std::thread> pool;
+    try {
+        for (size_t first = band; first < rows; first += band)
+            pool.emplace_back(gemm_detail::simd_rows<T>, lhs.data(),
+                              rhs.data(), result.data(), lhs.num_columns(),
+                              rhs.num_columns(), first,
+                              std::min(rows, first + band));
+    } catch (...) {
+        // If a thread cannot be started, the started ones are joined (a
+        // destroyed joinable thread terminates the program)
+        for (auto &t : pool) t.join();
+        throw;
+    }
+    gemm_detail::simd_rows(lhs.data(), rhs.data(), result.data(),
+                           lhs.num_columns(), rhs.num_columns(), 0,
+                           std::min(rows, band));
+    for (auto &t : pool) t.join();
+}
+
+#endif  // GEMM_H_
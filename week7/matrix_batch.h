@@ -0,0 +1,195 @@
+#ifndef MATRIX_BATCH_H_
+#define MATRIX_BATCH_H_
+
+#include <algorithm>    // std::min
+#include <cstddef>      // size_t
+#include <functional>   // std::ref, std::cref
+#include <stdexcept>    // std::invalid_argument, std::out_of_range
+#include <thread>       // std::thread
+#include <type_traits>  // std::is_arithmetic, std::enable_if
+#include <vector>       // std::vector
+
+/// A batch of 'count' independent matrices which all have the same shape.
+///
+/// Multiplying many small matrices one by one with matrix::operator* costs an
+/// allocation and a bounds checked triple loop per product. A batch stores all
+/// of them in one buffer instead, interleaved in groups of 'lanes' matrices
+/// (an "array of structures of arrays"):
+///
+///   data_[group * rows * columns * lanes + (row * columns + col) * lanes + l]
+///
+/// holds element (row, col) of matrix 'group * lanes + l'. The same element of
+/// 'lanes' neighbouring matrices therefore fills exactly one 64 byte SIMD
+/// register, so every SIMD lane works on its own matrix and the kernel never
+/// has to shuffle data around. The number of matrices is padded up to a
+/// multiple of 'lanes' with zero matrices.
+template <typename T,
+          typename =
+              typename std::enable_if<std::is_arithmetic<T>::value>::type>
+class matrix_batch {
+public:
+    /// Number of matrices that are processed side by side (one per SIMD lane
+    /// of a 64 byte register).
+    static constexpr size_t lanes = 64 / sizeof(T);
+
+private:
+    size_t count_;
+    size_t rows_;
+    size_t columns_;
+    std::vector<T> data_;
+
+    size_t group_size() const noexcept { return rows_ * columns_ * lanes; }
+
+    size_t offset(size_t index, size_t row, size_t column) const noexcept {
+        return (index / lanes) * group_size() +
+               (row * columns_ + column) * lanes + index % lanes;
+    }
+
+    // Computes the products of the groups [first, last). All loops over 'l'
+    // have a constant trip count of 'lanes' and work on contiguous memory,
+    // so the compiler turns each of them into a single SIMD instruction.
+    static void multiply_groups(const matrix_batch &lhs,
+                                const matrix_batch &rhs, matrix_batch &result,
+                                size_t first, size_t last) {
+        const size_t m = lhs.rows_, n = lhs.columns_, p = rhs.columns_;
+        for (size_t g = first; g < last; ++g) {
+            const T *a = lhs.data_.data() + g * lhs.group_size();
+            const T *b = rhs.data_.data() + g * rhs.group_size();
+            T *c = result.data_.data() + g * result.group_size();
+            for (size_t row = 0; row < m; ++row) {
+                for (size_t col = 0; col < p; ++col) {
+                    T acc[lanes] = {};
+                    for (size_t inner = 0; inner < n; ++inner) {
+                        const T *x = a + (row * n + inner) * lanes;
+                        const T *y = b + (inner * p + col) * lanes;
+                        for (size_t l = 0; l < lanes; ++l)
+                            acc[l] += x[l] * y[l];
+                    }
+                    T *z = c + (row * p + col) * lanes;
+                    for (size_t l = 0; l < lanes; ++l) z[l] = acc[l];
+                }
+            }
+        }
+    }
+
+public:
+    //////////////////
+    // Constructors //
+    //////////////////
+
+    /// Creates a batch of 'count' zero matrices of size 'rows' x 'columns'.
+    matrix_batch(size_t count, size_t rows, size_t columns)
+        : count_(count),
+          rows_(rows),
+          columns_(columns),
+          data_((count + lanes - 1) / lanes * rows * columns * lanes) {}
+
+    //////////////
+    // Functors //
+    //////////////
+
+    /// Access element ('row', 'column') of the matrix number 'index'.
+    /// Like matrix::operator(), 'row' and 'column' start at 1, while 'index'
+    /// starts at 0 like an index into an array of matrices.
+    T &operator()(size_t index, size_t row, size_t column) {
+        if (index >= count_ || (row - 1) >= rows_ || (column - 1) >= columns_)
+            throw std::out_of_range("Index out of bounds");
+        return data_[offset(index, row - 1, column - 1)];
+    }
+
+    /// For accessing elements of a constant batch
+    const T &operator()(size_t index, size_t row, size_t column) const {
+        if (index >= count_ || (row - 1) >= rows_ || (column - 1) >= columns_)
+            throw std::out_of_range("Index out of bounds");
+        return data_[offset(index, row - 1, column - 1)];
+    }
+
+    // --- Member functions
+    size_t size() const noexcept { return count_; }
+    size_t num_rows() const noexcept { return rows_; }
+    size_t num_columns() const noexcept { return columns_; }
+
+    /// Copies a matrix stored in row-major order into slot 'index'.
+    void load(size_t index, const T *row_major) {
+        if (index >= count_) throw std::out_of_range("Index out of bounds");
+        for (size_t row = 0; row < rows_; ++row)
+            for (size_t col = 0; col < columns_; ++col)
+                data_[offset(index, row, col)] =
+                    row_major[row * columns_ + col];
+    }
+
+    /// Copies the matrix in slot 'index' to 'row_major' in row-major order.
+    void store(size_t index, T *row_major) const {
+        if (index >= count_) throw std::out_of_range("Index out of bounds");
+        for (size_t row = 0; row < rows_; ++row)
+            for (size_t col = 0; col < columns_; ++col)
+                row_major[row * columns_ + col] =
+                    data_[offset(index, row, col)];
+    }
+
+    //////////////////////////
+    // Non-member functions //
+    //////////////////////////
+
+    /// Computes result[i] = lhs[i] * rhs[i] for every matrix in the batches.
+    /// 'result' must already have the right shape, so calling this in a loop
+    /// does not allocate. The batch is split into chunks of whole SIMD groups
+    /// which are handed to 'threads' threads (0: one per hardware thread).
+    friend void multiply(const matrix_batch &lhs, const matrix_batch &rhs,
+                         matrix_batch &result, unsigned threads = 0) {
+        if (lhs.num_columns() != rhs.num_rows())
+            throw std::invalid_argument(
+                "ERROR: Matrices have invalid sizes for "
+                "multiplications!\n\tThey ought to be "
+                "in the form: A(a, N) * B(N, b).");
+        if (lhs.size() != rhs.size() || lhs.size() != result.size() ||
+            result.num_rows() != lhs.num_rows() ||
+            result.num_columns() != rhs.num_columns())
+            throw std::invalid_argument("ERROR: Difference in batch size");
+
+        const size_t groups = (lhs.size() + lanes - 1) / lanes;
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        // Don't start a thread for less than a handful of groups
+        const size_t min_groups = 16;
+        size_t workers = std::min<size_t>(
+            threads ? threads : 1, (groups + min_groups - 1) / min_groups);
+        if (workers <= 1) {
+            multiply_groups(lhs, rhs, result, 0, groups);
+            return;
+        }
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        const size_t chunk = (groups + workers - 1) / workers;
+        try {
+            for (size_t w = 1; w < workers; ++w) {
+                size_t first = std::min(groups, w * chunk);
+                size_t last = std::min(groups, first + chunk);
+                pool.emplace_back(multiply_groups, std::cref(lhs),
+                                  std::cref(rhs), std::ref(result), first,
+                                  last);
+            }
+        } catch (...) {
+            // Destroying a joinable thread terminates: join the started
+            // ones before passing the error on
+            for (auto &t : pool) t.join();
+            throw;
+        }
+        // The calling thread takes the first chunk
+        multiply_groups(lhs, rhs, result, 0, std::min(groups, chunk));
+        for (auto &t : pool) t.join();
+    }
+
+    friend matrix_batch operator*(const matrix_batch &lhs,
+                                  const matrix_batch &rhs) {
+        matrix_batch result(lhs.size(), lhs.num_rows(), rhs.num_columns());
+        multiply(lhs, rhs, result);
+        return result;
+    }
+};
+
+// Out of class definition is needed since 'lanes' is odr-used (C++11)
+template <typename T, typename E>
+constexpr size_t matrix_batch<T, E>::lanes;
+
+#endif  // MATRIX_BATCH_H_
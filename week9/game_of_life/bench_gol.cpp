@@ -0,0 +1,168 @@
+// Throughput benchmark of the Game of Life steppers.
+//
+// For every size n, a random n x n seed (about a third of the cells alive) is
+// advanced by the same number of generations with
+//   - Grid:    game_of_life(const Grid &, size_t), one bool per cell
+//   - BitGrid: game_of_life(const BitGrid &, size_t), 64 cells per word
+//   - Parallel: ParallelLife with 1, 2, 4, ... up to N threads (including the
+//     time to start the threads and to split the grid into bands)
+// Reported are the cell updates per second, the speedup over Grid and whether
+// the result equals the one of Grid.
+//
+// A human readable table goes to stdout, the same data as CSV goes to the file
+// given with '--csv' (default: bench_gol.csv).
+//
+// Usage: ./bench_gol [--sizes 64,512,2048] [--generations N] [--threads N]
+//                    [--csv FILE]
+
+#include <algorithm>  // std::min
+#include <chrono>     // Timing capabilities
+#include <cstdlib>    // std::strtoul
+#include <cstring>    // std::strcmp
+#include <fstream>    // std::ofstream
+#include <iomanip>    // std::setw
+#include <iostream>
+#include <random>   // std::mt19937
+#include <sstream>  // std::stringstream
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bitgrid.h"
+#include "gol.h"
+#include "parallel_life.h"
+
+struct options {
+    std::vector<size_t> sizes = {64, 512, 2048};
+    size_t generations = 10;
+    unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+    std::string csv = "bench_gol.csv";
+};
+
+struct result_row {
+    std::string grid;
+    unsigned threads;
+    size_t size;
+    size_t generations;
+    double seconds;
+    double speedup;
+    bool ok;
+};
+
+Grid random_grid(size_t n) {
+    std::mt19937 gen(42);
+    std::bernoulli_distribution alive(1.0 / 3);
+    Grid grid(n, std::vector<bool>(n));
+    for (auto &row : grid)
+        for (size_t col = 0; col < n; ++col) row[col] = alive(gen);
+    return grid;
+}
+
+// Runs 'f' at least 'min_runs' times and for at least 'min_time' seconds and
+// returns the fastest run in seconds
+template <typename F>
+double best_time(F f, double min_time = 0.2, int min_runs = 3) {
+    double best = 1e300, total = 0;
+    for (int run = 0; run < min_runs || total < min_time; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double>(end - start).count();
+        best = std::min(best, t);
+        total += t;
+    }
+    return best;
+}
+
+void bench(const options &opt, std::vector<result_row> &rows) {
+    for (size_t n : opt.sizes) {
+        const Grid seed = random_grid(n);
+        const BitGrid bit_seed(seed);
+
+        Grid expected;
+        const double grid_seconds =
+            best_time([&] { expected = game_of_life(seed, opt.generations); });
+        rows.push_back(
+            {"Grid", 1, n, opt.generations, grid_seconds, 1.0, true});
+
+        BitGrid result;
+        const double bit_seconds = best_time(
+            [&] { result = game_of_life(bit_seed, opt.generations); });
+        rows.push_back({"BitGrid", 1, n, opt.generations, bit_seconds,
+                        grid_seconds / bit_seconds,
+                        result.to_grid() == expected});
+
+        std::vector<unsigned> thread_counts;
+        for (unsigned t = 1; t < opt.threads; t *= 2) thread_counts.push_back(t);
+        thread_counts.push_back(opt.threads);
+        for (unsigned t : thread_counts) {
+            const double seconds = best_time([&] {
+                result = parallel_game_of_life(bit_seed, opt.generations, t);
+            });
+            rows.push_back({"Parallel", t, n, opt.generations, seconds,
+                            grid_seconds / seconds,
+                            result.to_grid() == expected});
+        }
+    }
+}
+
+std::vector<size_t> parse_sizes(const std::string &list) {
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');)
+        sizes.push_back(std::strtoul(item.c_str(), nullptr, 10));
+    return sizes;
+}
+
+int main(int argc, char **argv) {
+    options opt;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--sizes") && i + 1 < argc)
+            opt.sizes = parse_sizes(argv[++i]);
+        else if (!std::strcmp(argv[i], "--generations") && i + 1 < argc)
+            opt.generations = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+            opt.threads = std::strtoul(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--csv") && i + 1 < argc)
+            opt.csv = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--sizes 64,512,2048] [--generations N]"
+                         " [--threads N] [--csv FILE]\n";
+            return 1;
+        }
+    }
+    if (opt.threads == 0) opt.threads = 1;
+    // game_of_life(const Grid &, size_t) needs at least one row
+    for (size_t &n : opt.sizes) n = std::max<size_t>(n, 1);
+
+    std::ofstream csv(opt.csv);
+    if (!csv) {
+        std::cerr << "Could not open the file " << opt.csv << '\n';
+        return 1;
+    }
+
+    std::vector<result_row> rows;
+    bench(opt, rows);
+
+    csv << "grid,threads,size,generations,mcells_per_second,speedup,ok\n";
+    std::cout << std::left << std::setw(10) << "grid" << std::right
+              << std::setw(8) << "threads" << std::setw(7) << "size"
+              << std::setw(13) << "generations" << std::setw(12) << "Mcells/s"
+              << std::setw(10) << "speedup" << "  check\n";
+    for (const auto &r : rows) {
+        const double mcells =
+            double(r.size) * r.size * r.generations / r.seconds / 1e6;
+        csv << r.grid << ',' << r.threads << ',' << r.size << ','
+            << r.generations << ',' << mcells << ',' << r.speedup << ','
+            << (r.ok ? "ok" : "FAIL") << '\n';
+        std::cout << std::left << std::setw(10) << r.grid << std::right
+                  << std::setw(8) << r.threads << std::setw(7) << r.size
+                  << std::setw(13) << r.generations << std::fixed
+                  << std::setprecision(1) << std::setw(12) << mcells
+                  << std::setw(10) << r.speedup << "  "
+                  << (r.ok ? "ok" : "FAIL") << '\n';
+    }
+
+    return 0;
+}
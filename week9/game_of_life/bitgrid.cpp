@@ -0,0 +1,124 @@
+#include "bitgrid.h"
+
+#include <stdexcept>
+
+namespace {
+
+// Number of words of a grid with 'rows' rows (plus the guard rows) of 'stride'
+// words. Throws for grids beyond BitGrid::max_words, before the product can
+// wrap around.
+size_t word_count(size_t rows, size_t stride) {
+    if (rows > BitGrid::max_words || stride > BitGrid::max_words / (rows + 2))
+        throw std::runtime_error("Grid too large");
+    return (rows + 2) * stride;
+}
+
+}  // namespace
+
+BitGrid::BitGrid(size_t rows, size_t cols)
+    : nRows(rows),
+      nCols(cols),
+      nWords(cols / 64 + (cols % 64 != 0)),
+      stride(nWords + 2),
+      words(word_count(rows, stride), 0) {}
+
+BitGrid::BitGrid(const Grid &grid)
+    : BitGrid(grid.size(), grid.empty() ? 0 : grid[0].size()) {
+    for (size_t row = 0; row < nRows; ++row)
+        for (size_t col = 0; col < nCols; ++col)
+            if (grid[row][col]) set(row, col, true);
+}
+
+Grid BitGrid::to_grid() const {
+    Grid grid(nRows, std::vector<bool>(nCols));
+    for (size_t row = 0; row < nRows; ++row)
+        for (size_t col = 0; col < nCols; ++col) grid[row][col] = get(row, col);
+    return grid;
+}
+
+size_t BitGrid::population() const {
+    size_t count = 0;
+    for (uint64_t word : words) count += __builtin_popcountll(word);
+    return count;
+}
+
+namespace {
+
+// Next state of the 64 cells of 'center', given the words left and right of
+// them in the rows above, the row itself and the row below. Each bit position
+// is an independent cell.
+inline uint64_t next_word(const uint64_t *above, const uint64_t *row,
+                          const uint64_t *below) {
+    // The neighbors to the west of bit j are bit j - 1 (and bit 63 of the
+    // word before for j = 0), those to the east bit j + 1
+    const uint64_t nw = (above[0] << 1) | (above[-1] >> 63);
+    const uint64_t n = above[0];
+    const uint64_t ne = (above[0] >> 1) | (above[1] << 63);
+    const uint64_t w = (row[0] << 1) | (row[-1] >> 63);
+    const uint64_t e = (row[0] >> 1) | (row[1] << 63);
+    const uint64_t sw = (below[0] << 1) | (below[-1] >> 63);
+    const uint64_t s = below[0];
+    const uint64_t se = (below[0] >> 1) | (below[1] << 63);
+
+    // Add up the eight neighbors bit-wise with full adders (sum, carry):
+    // three groups of (up to) three ...
+    const uint64_t s1 = nw ^ n ^ ne, c1 = (nw & n) | (ne & (nw ^ n));
+    const uint64_t s2 = w ^ e ^ sw, c2 = (w & e) | (sw & (w ^ e));
+    const uint64_t s3 = s ^ se, c3 = s & se;
+    // ... then the ones of the groups (giving bit 0 of the count) ...
+    const uint64_t ones = s1 ^ s2 ^ s3;
+    const uint64_t c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+    // ... and their twos (giving bit 1 and whether the count is >= 4)
+    const uint64_t t = c1 ^ c2 ^ c3;
+    const uint64_t fours = (c1 & c2) | (c3 & (c1 ^ c2)) | (t & c4);
+    const uint64_t twos = t ^ c4;
+
+    // Alive next: 3 neighbors, or 2 neighbors and alive now
+    return twos & ~fours & (ones | row[0]);
+}
+
+}  // namespace
+
+void BitGrid::step(BitGrid &next) const {
+    if (next.nRows != nRows || next.nCols != nCols) next = BitGrid(nRows, nCols);
+    // Grids without inner cells do not change
+    if (nRows < 3 || nCols < 3) {
+        next.words = words;
+        return;
+    }
+
+    const size_t last_word = (nCols - 1) / 64;
+    const uint64_t first_bit = 1;
+    const uint64_t last_bit = uint64_t(1) << ((nCols - 1) % 64);
+    for (size_t row = 1; row + 1 < nRows; ++row) {
+        const uint64_t *above = row_words(row - 1);
+        const uint64_t *center = row_words(row);
+        const uint64_t *below = row_words(row + 1);
+        uint64_t *out = next.row_words(row);
+        for (size_t w = 0; w < nWords; ++w)
+            out[w] = next_word(above + w, center + w, below + w);
+
+        // The bits after the last cell stay 0, the first and the last cell
+        // of the row keep their state
+        out[last_word] &= last_bit | (last_bit - 1);
+        out[0] = (out[0] & ~first_bit) | (center[0] & first_bit);
+        out[last_word] =
+            (out[last_word] & ~last_bit) | (center[last_word] & last_bit);
+    }
+
+    // The first and the last row keep their state
+    for (size_t w = 0; w < nWords; ++w) {
+        next.row_words(0)[w] = row_words(0)[w];
+        next.row_words(nRows - 1)[w] = row_words(nRows - 1)[w];
+    }
+}
+
+BitGrid game_of_life(const BitGrid &grid, const size_t N) {
+    BitGrid current = grid;
+    BitGrid successor(grid.rows(), grid.cols());
+    for (size_t nGenerations = 0; nGenerations < N; ++nGenerations) {
+        current.step(successor);
+        std::swap(current, successor);
+    }
+    return current;
+}
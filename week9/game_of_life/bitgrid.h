@@ -0,0 +1,80 @@
+#ifndef BITGRID_H
+#define BITGRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gol.h"
+
+// -- Bit-packed grid
+//
+// Stores 64 cells per 64-bit word (bit j of word w of a row is the cell in
+// column 64 * w + j) and computes the next generation for 64 cells at once:
+// the eight neighbors of all cells of a word are eight shifted words, and
+// their sum is computed with bitwise adders (SWAR, "SIMD within a register").
+//
+// Every row has an extra zero word on both sides and there is an extra zero
+// row above and below the grid, so the step needs no special cases at the
+// edges. As in game_of_life(const Grid &, size_t), the cells on the border of
+// the grid do not change.
+class BitGrid {
+public:
+    // Largest grid in words (with the guard words), 32 GiB. Larger sizes
+    // come from broken or hostile seed files rather than from real universes.
+    static constexpr size_t max_words = size_t(1) << 32;
+
+    BitGrid() = default;
+    // All cells dead. Throws std::runtime_error("Grid too large") for grids
+    // of more than max_words words.
+    BitGrid(size_t rows, size_t cols);
+    explicit BitGrid(const Grid &grid);
+
+    Grid to_grid() const;
+
+    size_t rows() const { return nRows; }
+    size_t cols() const { return nCols; }
+
+    bool get(size_t row, size_t col) const {
+        return (row_words(row)[col / 64] >> (col % 64)) & 1;
+    }
+    void set(size_t row, size_t col, bool alive) {
+        uint64_t &word = row_words(row)[col / 64];
+        const uint64_t bit = uint64_t(1) << (col % 64);
+        word = alive ? word | bit : word & ~bit;
+    }
+
+    // Number of living cells
+    size_t population() const;
+
+    // Computes the next generation into 'next', which gets the size of this
+    // grid
+    void step(BitGrid &next) const;
+
+    // Raw access to the words of a row (without the guard words), for code
+    // that fills or steps whole words. Bit j of word w is the cell in column
+    // 64 * w + j; the bits after the last column have to stay 0.
+    size_t words_per_row() const { return nWords; }
+    uint64_t *row_words(size_t row) { return &words[(row + 1) * stride + 1]; }
+    const uint64_t *row_words(size_t row) const {
+        return &words[(row + 1) * stride + 1];
+    }
+
+    bool operator==(const BitGrid &other) const {
+        return nRows == other.nRows && nCols == other.nCols &&
+               words == other.words;
+    }
+    bool operator!=(const BitGrid &other) const { return !(*this == other); }
+
+private:
+    size_t nRows = 0;
+    size_t nCols = 0;
+    size_t nWords = 0;  // per row, without the guard words
+    size_t stride = 0;  // nWords + 2
+    std::vector<uint64_t> words;
+};
+
+// Computes the Nth generation of a bit-packed grid
+BitGrid game_of_life(const BitGrid &grid, const size_t N);
+
+#endif  // BITGRID_H
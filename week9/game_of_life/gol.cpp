@@ -1,34 +1,11 @@
 #include "gol.h"
 
-// Reads A Grid (normally an initial seed) from file
-Grid read_grid(const std::string &filename) {
-    // Create an empty grid
-    // TODO: find a way to not hard code No. of rows and No. of columns
-    Grid grid(GRID_ROW, std::vector<bool>(GRID_COL, 0));
-
-    // Open the seed file
-    std::ifstream ifs;
-    ifs.open(filename);
+#include "loader.h"
 
-    // Check if you could open the file
-    if (!ifs) throw std::runtime_error("Could not open the file.");
-
-    // Fill the grid with initial grid
-    int row = 0;
-    for (std::string line; std::getline(ifs, line);) {
-        int column = 0;
-        for (char &c : line) {
-            // Get the numerical value of the character
-            // implicit cast: char -> bool
-            grid[row][column] = c - '0';
-            ++column;
-        }
-        ++row;
-    }
-
-    ifs.close();
-
-    return grid;
+// Reads A Grid (normally an initial seed) from file, in plain text or RLE
+// format. The size of the grid is taken from the file (see loader.h).
+Grid read_grid(const std::string &filename) {
+    return load_grid(filename).to_grid();
 }
 
 // Prints the grid
@@ -75,7 +52,8 @@ Grid game_of_life(const Grid &grid, const size_t N) {
         current.swap(successor);
     }
 
-    return successor;
+    // After the swap, current holds the Nth generation
+    return current;
 }
 
 // Writes a Grid to file
@@ -7,11 +7,6 @@
 #include <stdexcept>
 #include <vector>
 
-// Macros to set the size of the grid
-// size of the initial seed: 26x51
-#define GRID_ROW 26
-#define GRID_COL 51
-
 // -- Make my life easier
 using Grid = std::vector<std::vector<bool>>;
 
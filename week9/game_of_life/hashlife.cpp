@@ -0,0 +1,321 @@
+#include "hashlife.h"
+
+#include <algorithm>  // std::max, std::min
+#include <stdexcept>
+
+namespace {
+
+const size_t slab_size = 4096;  // nodes per slab
+
+template <typename Node>
+size_t hash_of(const Node *nw, const Node *ne, const Node *sw,
+               const Node *se) {
+    uint64_t h = reinterpret_cast<uintptr_t>(nw);
+    h = h * 0x9E3779B97F4A7C15 + reinterpret_cast<uintptr_t>(ne);
+    h = h * 0x9E3779B97F4A7C15 + reinterpret_cast<uintptr_t>(sw);
+    h = h * 0x9E3779B97F4A7C15 + reinterpret_cast<uintptr_t>(se);
+    // The low bits of pointers are all the same, mix the high ones in
+    return static_cast<size_t>(h ^ (h >> 32) ^ (h >> 47));
+}
+
+}  // namespace
+
+HashLife::HashLife(const BitGrid &seed, size_t max_nodes)
+    : maxNodes(max_nodes) {
+    cell[0] = Node{nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                   nullptr, 0,       0,       0,       false};
+    cell[1] = cell[0];
+    cell[1].population = 1;
+    table.assign(size_t(1) << 12, nullptr);
+    empties.push_back(&cell[0]);
+
+    // The seed goes into the bottom right quarter of the root, so its top
+    // left cell is at (0, 0)
+    unsigned level = 2;
+    while ((size_t(1) << level) < std::max(seed.rows(), seed.cols())) ++level;
+    Node *pattern = build(seed, level, 0, 0);
+    Node *e = empty(level);
+    root = join(e, e, e, pattern);
+}
+
+// --- Canonical nodes
+
+HashLife::Node *HashLife::allocate() {
+    if (free_nodes == nullptr) {
+        slabs.emplace_back(new Node[slab_size]);
+        Node *slab = slabs.back().get();
+        for (size_t i = 0; i < slab_size; ++i) {
+            slab[i].next = free_nodes;
+            free_nodes = &slab[i];
+        }
+    }
+    Node *n = free_nodes;
+    free_nodes = n->next;
+    return n;
+}
+
+void HashLife::rehash(size_t buckets) {
+    std::vector<Node *> old(buckets, nullptr);
+    old.swap(table);
+    for (Node *bucket : old) {
+        while (bucket != nullptr) {
+            Node *n = bucket;
+            bucket = n->next;
+            const size_t h =
+                hash_of(n->nw, n->ne, n->sw, n->se) & (table.size() - 1);
+            n->next = table[h];
+            table[h] = n;
+        }
+    }
+}
+
+HashLife::Node *HashLife::join(Node *nw, Node *ne, Node *sw, Node *se) {
+    const size_t h = hash_of(nw, ne, sw, se) & (table.size() - 1);
+    for (Node *n = table[h]; n != nullptr; n = n->next)
+        if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) return n;
+
+    const uint64_t population =
+        nw->population + ne->population + sw->population + se->population;
+    const uint8_t level = static_cast<uint8_t>(nw->level + 1);
+    Node *n = allocate();
+    *n = Node{nw, ne, sw, se, nullptr, nullptr, table[h], population, level, 0,
+              false};
+    table[h] = n;
+    if (++nNodes > table.size()) rehash(2 * table.size());
+    return n;
+}
+
+HashLife::Node *HashLife::empty(unsigned level) {
+    while (empties.size() <= level) {
+        Node *e = empties.back();
+        empties.push_back(join(e, e, e, e));
+    }
+    return empties[level];
+}
+
+HashLife::Node *HashLife::build(const BitGrid &seed, unsigned level,
+                                size_t row, size_t col) {
+    if (row >= seed.rows() || col >= seed.cols()) return empty(level);
+    if (level == 0) return &cell[seed.get(row, col)];
+
+    // Squares of up to 64 x 64 cells lie in one word of each row, which makes
+    // it cheap to skip the empty ones
+    const size_t size = size_t(1) << level;
+    if (size <= 64) {
+        const uint64_t ones =
+            size == 64 ? ~uint64_t(0) : (uint64_t(1) << size) - 1;
+        const uint64_t mask = ones << (col % 64);
+        bool alive = false;
+        for (size_t r = row; r < std::min(row + size, seed.rows()); ++r)
+            alive = alive || (seed.row_words(r)[col / 64] & mask) != 0;
+        if (!alive) return empty(level);
+    }
+
+    const size_t half = size / 2;
+    return join(build(seed, level - 1, row, col),
+                build(seed, level - 1, row, col + half),
+                build(seed, level - 1, row + half, col),
+                build(seed, level - 1, row + half, col + half));
+}
+
+// --- Stepping
+
+HashLife::Node *HashLife::center(Node *n) {
+    return join(n->nw->se, n->ne->sw, n->sw->ne, n->se->nw);
+}
+
+HashLife::Node *HashLife::horizontal(Node *w, Node *e) {
+    return join(w->ne, e->nw, w->se, e->sw);
+}
+
+HashLife::Node *HashLife::vertical(Node *n, Node *s) {
+    return join(n->sw, n->se, s->nw, s->ne);
+}
+
+HashLife::Node *HashLife::base(Node *n) {
+    // The 4 x 4 cells ...
+    const Node *quarter[2][2] = {{n->nw, n->ne}, {n->sw, n->se}};
+    bool alive[4][4];
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c) {
+            const Node *q = quarter[r / 2][c / 2];
+            const Node *cells[2][2] = {{q->nw, q->ne}, {q->sw, q->se}};
+            alive[r][c] = cells[r % 2][c % 2]->population != 0;
+        }
+
+    // ... give the 2 x 2 cells in the center one generation later
+    Node *next[2][2];
+    for (int r = 1; r < 3; ++r)
+        for (int c = 1; c < 3; ++c) {
+            int living_neighbors = 0;
+            for (int dr = -1; dr <= 1; ++dr)
+                for (int dc = -1; dc <= 1; ++dc)
+                    living_neighbors += (dr != 0 || dc != 0) &&
+                                        alive[r + dr][c + dc];
+            const bool lives =
+                living_neighbors == 3 || (living_neighbors == 2 && alive[r][c]);
+            next[r - 1][c - 1] = &cell[lives];
+        }
+    return join(next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+HashLife::Node *HashLife::advance(Node *n, unsigned j) {
+    const unsigned k = n->level;
+    if (n->population == 0) return empty(k - 1);
+    const bool full = j == k - 2;
+    if (full && n->result != nullptr) return n->result;
+    if (!full && n->slow_result != nullptr && n->slow_step == j)
+        return n->slow_result;
+
+    Node *result;
+    if (k == 2) {
+        result = base(n);
+    } else {
+        // The nine overlapping squares of level k - 1 ...
+        Node *square[3][3] = {
+            {n->nw, horizontal(n->nw, n->ne), n->ne},
+            {vertical(n->nw, n->sw), center(n), vertical(n->ne, n->se)},
+            {n->sw, horizontal(n->sw, n->se), n->se}};
+        // ... shrink to their centers, which at full speed are already half
+        // of the generations further ...
+        Node *part[3][3];
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                part[r][c] = full ? advance(square[r][c], k - 3)
+                                  : center(square[r][c]);
+        // ... and the four squares they form give the rest of the way
+        const unsigned rest = full ? k - 3 : j;
+        result = join(
+            advance(join(part[0][0], part[0][1], part[1][0], part[1][1]), rest),
+            advance(join(part[0][1], part[0][2], part[1][1], part[1][2]), rest),
+            advance(join(part[1][0], part[1][1], part[2][0], part[2][1]), rest),
+            advance(join(part[1][1], part[1][2], part[2][1], part[2][2]),
+                    rest));
+    }
+
+    if (full) {
+        n->result = result;
+    } else {
+        n->slow_result = result;
+        n->slow_step = static_cast<uint8_t>(j);
+    }
+    return result;
+}
+
+HashLife::Node *HashLife::expand(Node *n) {
+    Node *e = empty(n->level - 1);
+    return join(join(e, e, e, n->nw), join(e, e, n->ne, e),
+                join(e, n->sw, e, e), join(n->se, e, e, e));
+}
+
+bool HashLife::centered(Node *n) {
+    return n->nw->se->se->population + n->ne->sw->sw->population +
+               n->sw->ne->ne->population + n->se->nw->nw->population ==
+           n->population;
+}
+
+void HashLife::run(uint64_t N) {
+    if (N >= max_generations || nGenerations > UINT64_MAX - N)
+        throw std::overflow_error("Too many generations for HashLife");
+    for (unsigned j = 0; N > 0; ++j, N >>= 1) {
+        if ((N & 1) == 0) continue;
+        // advance() only returns the center of the root, so the pattern has
+        // to stay in there. In 2^j generations it grows by at most 2^j cells,
+        // and from the inner quarter of the root it is 2^(k-3) cells to the
+        // border of the center.
+        while (root->level < j + 3 || !centered(root)) {
+            if (root->level >= max_level)
+                throw std::overflow_error("Pattern too large for HashLife");
+            root = expand(root);
+        }
+        root = advance(root, j);
+        nGenerations += uint64_t(1) << j;
+
+        if (nNodes > maxNodes) {
+            collect_garbage();
+            // Keep the collections rare if most nodes are still in use
+            if (nNodes > maxNodes / 2) maxNodes *= 2;
+        }
+    }
+}
+
+// --- Garbage collection
+
+void HashLife::collect_garbage() {
+    // Mark the nodes the universe is made of, and the empty ones
+    std::vector<Node *> stack(empties.begin() + 1, empties.end());
+    stack.push_back(root);
+    while (!stack.empty()) {
+        Node *n = stack.back();
+        stack.pop_back();
+        if (n->level == 0 || n->marked) continue;
+        n->marked = true;
+        stack.push_back(n->nw);
+        stack.push_back(n->ne);
+        stack.push_back(n->sw);
+        stack.push_back(n->se);
+    }
+
+    // Results of nodes that stay may point to nodes that go
+    for (Node *n : table)
+        for (; n != nullptr; n = n->next) {
+            if (!n->marked) continue;
+            if (n->result != nullptr && !n->result->marked)
+                n->result = nullptr;
+            if (n->slow_result != nullptr && !n->slow_result->marked)
+                n->slow_result = nullptr;
+        }
+
+    // Unlink the unmarked nodes and put them into the free list
+    for (Node *&bucket : table) {
+        Node **link = &bucket;
+        while (Node *n = *link) {
+            if (n->marked) {
+                n->marked = false;
+                link = &n->next;
+            } else {
+                *link = n->next;
+                n->next = free_nodes;
+                free_nodes = n;
+                --nNodes;
+            }
+        }
+    }
+}
+
+// --- Looking at the universe
+
+uint64_t HashLife::population() const { return root->population; }
+
+BitGrid HashLife::grid(size_t rows, size_t cols, int64_t top,
+                       int64_t left) const {
+    BitGrid result(rows, cols);
+    const int64_t half = int64_t(1) << (root->level - 1);
+    fill(result, root, -half, -half, top, left);
+    return result;
+}
+
+void HashLife::fill(BitGrid &grid, const Node *n, int64_t top, int64_t left,
+                    int64_t grid_top, int64_t grid_left) const {
+    const int64_t size = int64_t(1) << n->level;
+    if (n->population == 0 || top + size <= grid_top ||
+        left + size <= grid_left ||
+        top >= grid_top + static_cast<int64_t>(grid.rows()) ||
+        left >= grid_left + static_cast<int64_t>(grid.cols()))
+        return;
+    if (n->level == 0) {
+        grid.set(top - grid_top, left - grid_left, true);
+        return;
+    }
+    const int64_t half = size / 2;
+    fill(grid, n->nw, top, left, grid_top, grid_left);
+    fill(grid, n->ne, top, left + half, grid_top, grid_left);
+    fill(grid, n->sw, top + half, left, grid_top, grid_left);
+    fill(grid, n->se, top + half, left + half, grid_top, grid_left);
+}
+
+BitGrid hashlife(const BitGrid &grid, const uint64_t N) {
+    HashLife life(grid);
+    life.run(N);
+    return life.grid(grid.rows(), grid.cols());
+}
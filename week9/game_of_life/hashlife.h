@@ -0,0 +1,122 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "bitgrid.h"
+
+// -- HashLife
+//
+// Gosper's algorithm for running patterns for very many generations. The
+// universe is a quadtree: a node of level k is a square of 2^k x 2^k cells
+// made of four nodes of level k - 1, down to the two cells (dead and alive)
+// at level 0. Nodes are hash-consed: the table of canonical nodes holds
+// every square only once, so equal parts of the universe (empty space above
+// all) are the same node. That makes it possible to remember for every node
+// its result: the center 2^(k-1) x 2^(k-1) square, 2^(k-2) generations later.
+// It only depends on the node, and once computed, every other occurrence of
+// the same square, at any place and any time, gets it for free.
+//
+// Unlike game_of_life(), which freezes the border of the grid, HashLife runs
+// on an unbounded plane. The seed lies with its top left cell at (0, 0) and
+// patterns may grow beyond it in every direction. For patterns that never
+// touch the border of the grid, both give the same result.
+//
+// Nodes that the universe does not use anymore are freed by a garbage
+// collection when the table grows past a limit.
+class HashLife {
+public:
+    // Garbage collections start when the table holds more than 'max_nodes'
+    // nodes (and the limit grows if most of them are still in use)
+    explicit HashLife(const BitGrid &seed, size_t max_nodes = 1 << 22);
+
+    HashLife(const HashLife &) = delete;
+    HashLife &operator=(const HashLife &) = delete;
+
+    // The root may grow up to this level, so that the coordinates of all its
+    // cells fit into an int64_t
+    static constexpr unsigned max_level = 62;
+    // run() takes fewer generations than this at once: a step of 2^j
+    // generations needs a root of level j + 3
+    static constexpr uint64_t max_generations = uint64_t(1) << (max_level - 2);
+
+    // Advances the universe by N generations, in steps of powers of two.
+    // Throws std::overflow_error, and leaves the universe as it was, for
+    // N >= max_generations; throws it as well if the pattern grows beyond a
+    // root of max_level (after some of the steps).
+    void run(uint64_t N);
+
+    // The rows x cols cells of the plane starting at (top, left)
+    BitGrid grid(size_t rows, size_t cols, int64_t top = 0,
+                 int64_t left = 0) const;
+
+    uint64_t generation() const { return nGenerations; }
+    // Number of living cells
+    uint64_t population() const;
+    // Number of nodes in the table of canonical nodes
+    size_t node_count() const { return nNodes; }
+
+    // Frees all nodes that are not part of the current universe and forgets
+    // the results that point to them
+    void collect_garbage();
+
+private:
+    struct Node {
+        Node *nw, *ne, *sw, *se;  // nullptr for cells (level 0)
+        Node *result;             // center after 2^(level - 2) generations
+        Node *slow_result;        // center after 2^slow_step generations
+        Node *next;               // in the bucket of the table, or free list
+        uint64_t population;
+        uint8_t level;
+        uint8_t slow_step;
+        bool marked;  // by the garbage collection
+    };
+
+    // The canonical node with these children
+    Node *join(Node *nw, Node *ne, Node *sw, Node *se);
+    Node *empty(unsigned level);
+    Node *build(const BitGrid &seed, unsigned level, size_t row, size_t col);
+
+    // The center of a node and of two nodes next to each other, one level
+    // below the nodes
+    Node *center(Node *n);
+    Node *horizontal(Node *w, Node *e);
+    Node *vertical(Node *n, Node *s);
+
+    // The center of n (level k), 2^j generations later, for j <= k - 2
+    Node *advance(Node *n, unsigned j);
+    // advance() for the 4 x 4 squares
+    Node *base(Node *n);
+    // Puts the root into the center of a node one level higher
+    Node *expand(Node *n);
+    // Whether all living cells are in the center 2^(k-2) x 2^(k-2) square
+    bool centered(Node *n);
+
+    void fill(BitGrid &grid, const Node *n, int64_t top, int64_t left,
+              int64_t grid_top, int64_t grid_left) const;
+
+    Node *allocate();
+    void rehash(size_t buckets);
+
+    Node cell[2];                 // dead and alive cell
+    std::vector<Node *> empties;  // empties[k]: the empty node of level k
+    std::vector<Node *> table;    // buckets of the canonical nodes
+    size_t nNodes = 0;
+    size_t maxNodes;
+
+    // Nodes come from slabs, unused ones wait in a free list
+    std::vector<std::unique_ptr<Node[]>> slabs;
+    Node *free_nodes = nullptr;
+
+    Node *root;  // centered at (0, 0): it covers [-2^(k-1), 2^(k-1))^2
+    uint64_t nGenerations = 0;
+};
+
+// Computes the Nth generation of the cells of 'grid' on an unbounded plane
+// (see HashLife) and returns the part of the plane the grid covers
+BitGrid hashlife(const BitGrid &grid, const uint64_t N);
+
+#endif  // HASHLIFE_H
@@ -0,0 +1,338 @@
+#include "loader.h"
+
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, madvise, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close
+
+#include <algorithm>  // std::max, std::min
+#include <cctype>     // std::isalpha, std::toupper
+#include <cerrno>     // errno
+#include <cstdint>
+#include <cstdlib>  // std::strtoul
+#include <cstring>  // std::memchr, std::memcpy
+#include <fstream>  // std::ofstream
+#include <stdexcept>
+
+namespace {
+
+// A file mapped read-only into memory, so the parsers can work on one big
+// array of characters without copying it into buffers first
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &filename) {
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Could not open the file.");
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not read the file.");
+        }
+        length = static_cast<size_t>(st.st_size);
+        // mmap() does not take empty files
+        if (length > 0) {
+            void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Could not map the file.");
+            }
+            ::madvise(p, length, MADV_SEQUENTIAL);
+            addr = static_cast<const char *>(p);
+        }
+        // The mapping stays valid without the descriptor
+        ::close(fd);
+    }
+    ~MappedFile() {
+        if (addr != nullptr) ::munmap(const_cast<char *>(addr), length);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return addr; }
+    size_t size() const { return length; }
+
+private:
+    const char *addr = nullptr;
+    size_t length = 0;
+};
+
+// Calls f(line, length) for every line, without the line break ("\n" or
+// "\r\n"). A line break at the end of the data does not start another line.
+template <typename F>
+void for_each_line(const char *data, size_t size, F f) {
+    const char *end = data + size;
+    for (const char *p = data; p < end;) {
+        const char *nl =
+            static_cast<const char *>(std::memchr(p, '\n', end - p));
+        const char *line_end = nl != nullptr ? nl : end;
+        size_t length = line_end - p;
+        if (length > 0 && p[length - 1] == '\r') --length;
+        f(p, length);
+        p = nl != nullptr ? nl + 1 : end;
+    }
+}
+
+// -- Plain text
+
+bool is_comment(const char *line, size_t length) {
+    return length > 0 && line[0] == '!';
+}
+
+bool plain_cell(char c, size_t row) {
+    switch (c) {
+        case '1':
+        case 'O':
+        case '*':
+            return true;
+        case '0':
+        case '.':
+            return false;
+    }
+    throw std::runtime_error("Invalid cell in row " + std::to_string(row + 1) +
+                             ".");
+}
+
+// Packs 8 cells written as '0' and '1' into the bits of a byte (the first
+// cell in bit 0). Returns false if any of the characters is something else.
+inline bool pack8(const char *chars, uint64_t &bits) {
+    uint64_t x;
+    std::memcpy(&x, chars, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    // '0' is 0x30 and '1' is 0x31
+    if ((x | 0x0101010101010101) != 0x3131313131313131) return false;
+    // Moves bit 0 of byte k to bit 56 + k
+    bits = ((x & 0x0101010101010101) * 0x0102040810204080) >> 56;
+    return true;
+}
+
+// The inverse of pack8(): writes the low 8 bits as 8 characters '0' and '1'
+// (bit 0 first)
+inline void unpack8(uint64_t bits, char *chars) {
+    // Copies the byte into all 8 bytes and keeps bit k in byte k ...
+    uint64_t x = ((bits & 0xFF) * 0x0101010101010101) & 0x8040201008040201;
+    // ... which sets bit 7 of the bytes that keep a bit, then moves it to
+    // bit 0
+    x = ((x + 0x7F7F7F7F7F7F7F7F) >> 7) & 0x0101010101010101;
+    x |= 0x3030303030303030;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    x = __builtin_bswap64(x);
+#endif
+    std::memcpy(chars, &x, 8);
+}
+
+// -- RLE
+
+std::string trim(const std::string &s) {
+    const size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+}
+
+size_t header_number(const std::string &value) {
+    char *end = nullptr;
+    errno = 0;
+    const unsigned long n = std::strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || value[0] == '-')
+        throw std::runtime_error("Invalid size in the RLE header.");
+    // Sizes that fit, but are too large for a BitGrid, throw when the grid
+    // gets created
+    if (errno == ERANGE) throw std::runtime_error("Grid too large");
+    return n;
+}
+
+// Only Conway's rule is supported, in any of its usual spellings
+void check_rule(const std::string &value) {
+    std::string rule;
+    for (char c : value)
+        if (c != ' ') rule += static_cast<char>(std::toupper(c));
+    if (rule != "B3/S23" && rule != "S23/B3" && rule != "23/3")
+        throw std::runtime_error("Unsupported rule in the RLE header.");
+}
+
+// Sets the cells [col, col + n) of a row
+void set_run(BitGrid &grid, size_t row, size_t col, size_t n) {
+    uint64_t *words = grid.row_words(row);
+    while (n > 0) {
+        const size_t bit = col % 64;
+        const size_t take = std::min<size_t>(n, 64 - bit);
+        const uint64_t ones =
+            take == 64 ? ~uint64_t(0) : (uint64_t(1) << take) - 1;
+        words[col / 64] |= ones << bit;
+        col += take;
+        n -= take;
+    }
+}
+
+bool is_rle(const char *data, size_t size) {
+    const char *end = data + size;
+    for (const char *p = data; p < end; ++p) {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') continue;
+        if (*p != '#') return *p == 'x';
+        // Skip the comment line
+        const char *nl =
+            static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (nl == nullptr) break;
+        p = nl;
+    }
+    return false;
+}
+
+}  // namespace
+
+BitGrid parse_plain(const char *data, size_t size) {
+    // First pass: the size of the grid
+    size_t rows = 0, cols = 0;
+    for_each_line(data, size, [&](const char *line, size_t length) {
+        if (is_comment(line, length)) return;
+        ++rows;
+        cols = std::max(cols, length);
+    });
+
+    // Second pass: the cells, 64 at a time where the line is long enough
+    BitGrid grid(rows, cols);
+    size_t row = 0;
+    for_each_line(data, size, [&](const char *line, size_t length) {
+        if (is_comment(line, length)) return;
+        uint64_t *words = grid.row_words(row);
+        size_t col = 0;
+        for (; col + 64 <= length; col += 64) {
+            uint64_t word = 0;
+            for (size_t byte = 0; byte < 8; ++byte) {
+                const char *chars = line + col + 8 * byte;
+                uint64_t bits;
+                if (!pack8(chars, bits)) {
+                    bits = 0;
+                    for (size_t k = 0; k < 8; ++k)
+                        bits |= uint64_t(plain_cell(chars[k], row)) << k;
+                }
+                word |= bits << (8 * byte);
+            }
+            words[col / 64] = word;
+        }
+        for (; col < length; ++col)
+            if (plain_cell(line[col], row))
+                words[col / 64] |= uint64_t(1) << (col % 64);
+        ++row;
+    });
+    return grid;
+}
+
+BitGrid parse_rle(const char *data, size_t size) {
+    const char *p = data;
+    const char *end = data + size;
+
+    // Skip the comment lines before the header
+    while (p < end && (*p == '#' || *p == '\n' || *p == '\r' || *p == ' ')) {
+        if (*p != '#') {
+            ++p;
+            continue;
+        }
+        const char *nl =
+            static_cast<const char *>(std::memchr(p, '\n', end - p));
+        p = nl != nullptr ? nl + 1 : end;
+    }
+
+    // The header: "x = <cols>, y = <rows>[, rule = <rule>]"
+    if (p == end) throw std::runtime_error("Missing RLE header.");
+    const char *nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    const std::string header(p, nl != nullptr ? nl : end);
+    p = nl != nullptr ? nl + 1 : end;
+    size_t rows = 0, cols = 0;
+    bool has_x = false, has_y = false;
+    size_t start = 0;
+    while (start <= header.size()) {
+        size_t comma = header.find(',', start);
+        if (comma == std::string::npos) comma = header.size();
+        const std::string item = header.substr(start, comma - start);
+        start = comma + 1;
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            if (trim(item).empty()) continue;
+            throw std::runtime_error("Invalid RLE header.");
+        }
+        const std::string key = trim(item.substr(0, eq));
+        const std::string value = trim(item.substr(eq + 1));
+        if (key == "x") {
+            cols = header_number(value);
+            has_x = true;
+        } else if (key == "y") {
+            rows = header_number(value);
+            has_y = true;
+        } else if (key == "rule") {
+            check_rule(value);
+        }
+    }
+    if (!has_x || !has_y)
+        throw std::runtime_error("Missing size in the RLE header.");
+
+    // The runs: "<count><tag>", where the count defaults to 1 and the tag is
+    // 'b' (dead), 'o' (alive) or '$' (end of row); '!' ends the pattern. The
+    // position never goes past the size from the header (col <= cols,
+    // row <= rows), and the checks are written so that they can not wrap.
+    BitGrid grid(rows, cols);
+    const char *too_large = "RLE pattern is larger than its header says.";
+    size_t row = 0, col = 0, count = 0;
+    for (; p < end; ++p) {
+        const char c = *p;
+        if (c >= '0' && c <= '9') {
+            const size_t digit = c - '0';
+            if (count > (SIZE_MAX - digit) / 10)
+                throw std::runtime_error(
+                    "Run count too large in the RLE pattern.");
+            count = count * 10 + digit;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        const size_t n = count > 0 ? count : 1;
+        count = 0;
+        if (c == 'b' || c == '.') {
+            if (n > cols - col) throw std::runtime_error(too_large);
+            col += n;
+        } else if (c == '$') {
+            if (n > rows - row) throw std::runtime_error(too_large);
+            row += n;
+            col = 0;
+        } else if (c == '!') {
+            break;
+        } else if (std::isalpha(static_cast<unsigned char>(c))) {
+            // Any other state of multi-state patterns counts as alive
+            if (row >= rows || n > cols - col)
+                throw std::runtime_error(too_large);
+            set_run(grid, row, col, n);
+            col += n;
+        } else {
+            throw std::runtime_error("Invalid character in the RLE pattern.");
+        }
+    }
+    return grid;
+}
+
+BitGrid load_grid(const std::string &filename) {
+    const MappedFile file(filename);
+    if (is_rle(file.data(), file.size()))
+        return parse_rle(file.data(), file.size());
+    return parse_plain(file.data(), file.size());
+}
+
+void write_grid(const std::string &filename, const BitGrid &grid) {
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs) throw std::runtime_error("Could not open the file.");
+
+    // One row at a time, 8 cells per unpack8()
+    const size_t cols = grid.cols();
+    std::string line(cols + 1, '\n');
+    for (size_t row = 0; row < grid.rows(); ++row) {
+        const uint64_t *words = grid.row_words(row);
+        size_t col = 0;
+        for (; col + 8 <= cols; col += 8)
+            unpack8(words[col / 64] >> (col % 64), &line[col]);
+        for (; col < cols; ++col)
+            line[col] = (words[col / 64] >> (col % 64)) & 1 ? '1' : '0';
+        ofs.write(line.data(), line.size());
+    }
+
+    ofs.close();
+    if (!ofs) throw std::runtime_error("Could not write the file.");
+}
@@ -0,0 +1,37 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <cstddef>
+#include <string>
+
+#include "bitgrid.h"
+
+// -- Loading seeds of any size (and writing grids back)
+//
+// Two formats are understood, and the size of the grid is taken from the
+// file:
+//   - plain text: one line per row, one character per cell ('1', 'O' or '*'
+//     alive, '0' or '.' dead). Lines starting with '!' are comments (as in
+//     the .cells format), shorter lines are padded with dead cells and the
+//     longest line gives the number of columns.
+//   - RLE: the run length encoded format of most pattern collections,
+//     "x = <cols>, y = <rows>[, rule = B3/S23]" followed by runs like "3o2b$".
+//
+// All functions throw std::runtime_error on files they cannot read, and
+// "Grid too large" for sizes beyond BitGrid::max_words (whether declared in
+// an RLE header or counted in a plain text file).
+
+// Reads a seed file, detecting its format: RLE if the first line that is not
+// a '#' comment starts with 'x', plain text otherwise. The file is mapped
+// into memory instead of read line by line.
+BitGrid load_grid(const std::string &filename);
+
+// Parse a seed that is already in memory
+BitGrid parse_plain(const char *data, size_t size);
+BitGrid parse_rle(const char *data, size_t size);
+
+// Writes 'grid' as plain text, '0' and '1' (like write_grid() of a Grid), a
+// whole row at a time straight from the words of the BitGrid
+void write_grid(const std::string &filename, const BitGrid &grid);
+
+#endif  // LOADER_H
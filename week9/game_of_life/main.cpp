@@ -20,24 +20,85 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cctype>   // std::isdigit
+#include <cerrno>   // errno
+#include <climits>  // UINT_MAX
+#include <cstdlib>  // std::strtoull
+#include <new>      // std::bad_alloc
+#include <string>
+#include <vector>
+
+#include "bitgrid.h"
 #include "gol.h"
+#include "hashlife.h"
+#include "loader.h"
+#include "parallel_life.h"
+
+// Parses a decimal number without sign. Returns false for anything else,
+// including trailing characters and numbers that are too large.
+bool parse_number(const std::string &text, uint64_t &value) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+        return false;
+    char *end = nullptr;
+    errno = 0;
+    value = std::strtoull(text.c_str(), &end, 10);
+    return *end == '\0' && errno != ERANGE;
+}
 
-int main() {
-    Grid grid;
+// Usage: ./gol [--hashlife] [seed file] [generations] [threads]
+// The seed is a plain text or RLE file of any size (initial_grid.txt, 10
+// generations and one thread per core by default), the result goes to
+// out_grid.txt.
+// With --hashlife, the generations are computed by HashLife instead of cell by
+// cell, which takes billions of generations in stride. HashLife runs on an
+// unbounded plane instead of freezing the border of the grid (see hashlife.h);
+// the result is the part of the plane that the seed covers.
+int main(int argc, char **argv) {
+    bool use_hashlife = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--hashlife")
+            use_hashlife = true;
+        else
+            args.push_back(argv[i]);
+    }
+    const std::string seed = args.size() > 0 ? args[0] : "initial_grid.txt";
+    uint64_t generations = 10, threads = 0;
+    if (args.size() > 3 ||
+        (args.size() > 1 && !parse_number(args[1], generations)) ||
+        (args.size() > 2 &&
+         (!parse_number(args[2], threads) || threads > UINT_MAX))) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--hashlife] [seed file] [generations] [threads]\n";
+        return 1;
+    }
+
+    BitGrid grid;
     // Read the seed file
     try {
-        grid = read_grid("initial_grid.txt");
+        grid = load_grid(seed);
     } catch (const std::runtime_error &e) {
         std::cerr << e.what() << '\n';
         return 1;
+    } catch (const std::bad_alloc &) {
+        std::cerr << "Not enough memory for the grid.\n";
+        return 1;
     }
 
-    // Write results
+    // Write results (computed either by HashLife or on the bit-packed grid, 64
+    // cells at once, by 'threads' threads)
     try {
-        write_grid("out_grid.txt", game_of_life(grid, 10));
+        const BitGrid result =
+            use_hashlife ? hashlife(grid, generations)
+                         : parallel_game_of_life(grid, generations,
+                                                 static_cast<unsigned>(threads));
+        write_grid("out_grid.txt", result);
     } catch (const std::runtime_error &e) {
         std::cerr << e.what() << '\n';
         return 1;
+    } catch (const std::bad_alloc &) {
+        std::cerr << "Not enough memory for the generations.\n";
+        return 1;
     }
 
     return 0;
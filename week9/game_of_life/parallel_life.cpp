@@ -0,0 +1,167 @@
+#include "parallel_life.h"
+
+#include <algorithm>  // std::copy, std::min
+
+namespace {
+
+unsigned band_count(size_t rows, unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    // Every band needs at least one inner row
+    const size_t inner = rows > 2 ? rows - 2 : 1;
+    return static_cast<unsigned>(std::min<size_t>(threads, inner));
+}
+
+void copy_row(const BitGrid &from, size_t from_row, BitGrid &to,
+              size_t to_row) {
+    const uint64_t *words = from.row_words(from_row);
+    std::copy(words, words + from.words_per_row(), to.row_words(to_row));
+}
+
+}  // namespace
+
+ParallelLife::ParallelLife(const BitGrid &seed, unsigned threads)
+    : nRows(seed.rows()),
+      nCols(seed.cols()),
+      band(band_count(nRows, threads)),
+      barrier(static_cast<unsigned>(band.size())) {
+    // The inner rows [1, nRows - 1) are split evenly, each band also gets
+    // the row above and below its part. A grid without inner rows does not
+    // change and goes into a single band as a whole.
+    const size_t n = band.size();
+    if (nRows < 3) {
+        band[0].rows = nRows;
+    } else {
+        for (size_t b = 0; b < n; ++b) {
+            const size_t begin = 1 + (nRows - 2) * b / n;
+            const size_t end = 1 + (nRows - 2) * (b + 1) / n;
+            band[b].first = begin - 1;
+            band[b].rows = end - begin + 2;
+        }
+    }
+
+    // If starting a worker or allocating a band fails, the workers started so
+    // far have to be joined here: the destructor does not run
+    try {
+        for (size_t b = 1; b < n; ++b)
+            workers.emplace_back([this, b] { work(b); });
+
+        // Every thread allocates (and so first touches) the memory of its
+        // band
+        dispatch([&](size_t b) {
+            Band &my = band[b];
+            my.buffer[0] = BitGrid(my.rows, nCols);
+            my.buffer[1] = BitGrid(my.rows, nCols);
+            for (size_t row = 0; row < my.rows; ++row)
+                copy_row(seed, my.first + row, my.buffer[0], row);
+        });
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+ParallelLife::~ParallelLife() { stop(); }
+
+void ParallelLife::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : workers) t.join();
+    workers.clear();
+}
+
+void ParallelLife::run(size_t N) {
+    if (N == 0) return;
+    dispatch([&](size_t b) { advance(b, N); });
+    current = (current + N) % 2;
+}
+
+BitGrid ParallelLife::grid() const {
+    BitGrid result(nRows, nCols);
+    // The halo rows are equal to the rows they copy, so the order does not
+    // matter
+    for (const Band &my : band)
+        for (size_t row = 0; row < my.rows; ++row)
+            copy_row(my.buffer[current], row, result, my.first + row);
+    return result;
+}
+
+void ParallelLife::advance(size_t b, size_t N) {
+    Band &my = band[b];
+    for (size_t generation = 0; generation < N; ++generation) {
+        const size_t from = (current + generation) % 2;
+        const size_t to = 1 - from;
+        my.buffer[from].step(my.buffer[to]);
+
+        // Wait until the neighbors are done as well ...
+        barrier.wait();
+
+        // ... and take their new edge rows as halos
+        if (b > 0) {
+            const Band &above = band[b - 1];
+            copy_row(above.buffer[to], above.rows - 2, my.buffer[to], 0);
+        }
+        if (b + 1 < band.size()) {
+            const Band &below = band[b + 1];
+            copy_row(below.buffer[to], 1, my.buffer[to], my.rows - 1);
+        }
+    }
+}
+
+void ParallelLife::dispatch(const std::function<void(size_t)> &todo) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        job = &todo;
+        ++round;
+        pending = workers.size();
+        error = nullptr;
+    }
+    wake.notify_all();
+
+    std::exception_ptr failure;
+    try {
+        todo(0);
+    } catch (...) {
+        failure = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [this] { return pending == 0; });
+    if (!failure) failure = error;
+    if (failure) std::rethrow_exception(failure);
+}
+
+void ParallelLife::work(size_t b) {
+    size_t seen = 0;
+    while (true) {
+        const std::function<void(size_t)> *todo;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || round != seen; });
+            if (stopping) return;
+            seen = round;
+            todo = job;
+        }
+
+        std::exception_ptr failure;
+        try {
+            (*todo)(b);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (failure && !error) error = failure;
+        if (--pending == 0) finished.notify_one();
+    }
+}
+
+BitGrid parallel_game_of_life(const BitGrid &grid, const size_t N,
+                              unsigned threads) {
+    ParallelLife life(grid, threads);
+    life.run(N);
+    return life.grid();
+}
@@ -0,0 +1,111 @@
+#ifndef PARALLEL_LIFE_H
+#define PARALLEL_LIFE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bitgrid.h"
+
+// -- Barrier
+//
+// Blocks each of 'threads' threads in wait() until all of them got there.
+// The last one to arrive flips the phase, the others spin on it (and yield
+// after a while, so it also works with more threads than cores).
+class Barrier {
+public:
+    explicit Barrier(unsigned threads) : threads(threads) {}
+
+    void wait() {
+        const unsigned my_phase = phase.load(std::memory_order_relaxed);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == threads) {
+            arrived.store(0, std::memory_order_relaxed);
+            phase.store(my_phase + 1, std::memory_order_release);
+            return;
+        }
+        for (unsigned spins = 0;
+             phase.load(std::memory_order_acquire) == my_phase; ++spins)
+            if (spins >= 1000) std::this_thread::yield();
+    }
+
+private:
+    const unsigned threads;
+    std::atomic<unsigned> arrived{0};
+    std::atomic<unsigned> phase{0};
+};
+
+// -- Parallel stepper
+//
+// Splits the rows of a grid into one band per thread. Every band is a BitGrid
+// of its own (allocated by the thread that works on it) with one extra halo
+// row above and below, which holds the neighboring row of the band above or
+// below. A generation is:
+//   1. every thread steps its band (the halo rows act as the frozen border),
+//   2. all threads meet at a barrier,
+//   3. every thread copies the new edge rows of its neighbors into its halos.
+// Each band has two buffers and the generation decides which one is current,
+// so a thread can read its neighbors' rows while they already compute the
+// next generation into the other buffer: one barrier per generation is
+// enough. The threads stay around between calls of run().
+//
+// The result is the same, bit for bit, as that of game_of_life().
+class ParallelLife {
+public:
+    // 'threads' in total (0: one per hardware thread), including the thread
+    // that calls run()
+    explicit ParallelLife(const BitGrid &seed, unsigned threads = 0);
+    ~ParallelLife();
+
+    ParallelLife(const ParallelLife &) = delete;
+    ParallelLife &operator=(const ParallelLife &) = delete;
+
+    // Advances the grid by N generations
+    void run(size_t N);
+
+    // The current generation
+    BitGrid grid() const;
+
+    // Number of bands (= threads used)
+    size_t bands() const { return band.size(); }
+
+private:
+    struct Band {
+        size_t first = 0;  // first row of the grid in the band (with halo)
+        size_t rows = 0;   // rows in the band (with halos)
+        BitGrid buffer[2];
+    };
+
+    // Runs job(b) for every band b, each on the thread of the band (band 0
+    // on the calling thread), and returns when all are done
+    void dispatch(const std::function<void(size_t)> &job);
+    void work(size_t b);
+    void advance(size_t b, size_t N);
+    // Ends and joins the workers
+    void stop();
+
+    size_t nRows, nCols;
+    std::vector<Band> band;
+    size_t current = 0;  // buffer holding the current generation
+    Barrier barrier;
+
+    std::vector<std::thread> workers;  // worker t runs band t + 1
+    std::mutex lock;
+    std::condition_variable wake, finished;
+    // Guarded by 'lock'
+    const std::function<void(size_t)> *job = nullptr;
+    size_t round = 0;    // incremented for every job
+    size_t pending = 0;  // workers that did not finish the job yet
+    bool stopping = false;
+    std::exception_ptr error;
+};
+
+// Computes the Nth generation with ParallelLife
+BitGrid parallel_game_of_life(const BitGrid &grid, const size_t N,
+                              unsigned threads = 0);
+
+#endif  // PARALLEL_LIFE_H